@@ -0,0 +1,14 @@
+#include "adaptive.h"
+#include "search.h"
+
+template <typename B>
+DropMove elTetrisExpectimax(const B &board, PieceType piece, int depth, MoveSet moves, long &nodes) {
+  ExpectimaxSearch<decltype(elTetrisEvaluator), B> search(elTetrisEvaluator, 4, moves);
+  auto move = search.best(board, piece, depth).first;
+  nodes += search.nodes;
+  return move;
+}
+
+#define INSTANTIATE(B) \
+  template DropMove elTetrisExpectimax(const B &board, PieceType piece, int depth, MoveSet moves, long &nodes);
+FOR_EACH_BOARD(INSTANTIATE)
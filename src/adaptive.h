@@ -0,0 +1,96 @@
+#ifndef _ADAPTIVE_H_
+#define _ADAPTIVE_H_
+
+#include "tetris.h"
+#include "ai.h"
+#include "eltetris.h"
+#include "rowkernels.h"
+
+#include <array>
+#include <chrono>
+#include <iostream>
+
+// How much trouble the stack is in: its height plus the holes in it.
+template <typename B>
+int boardDanger(const B &board) {
+  return board.stackHeight() + rowHoles<DefaultRowKernels<B::width()>>(board);
+}
+
+// El-Tetris expectimax looking depth-1 pieces ahead, see ExpectimaxSearch.
+// Adds the placements it evaluated to nodes.
+template <typename B>
+DropMove elTetrisExpectimax(const B &board, PieceType piece, int depth, MoveSet moves, long &nodes);
+
+// El-Tetris expectimax at a fixed depth.
+struct ElTetrisExpectimax {
+  MoveSet moves;
+  int depth;
+
+  explicit ElTetrisExpectimax(const PlayerOptions &options = {}): moves(options.moves), depth(options.depth) {}
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) const {
+    long nodes = 0;
+    return elTetrisExpectimax(board, piece, depth, moves, nodes);
+  }
+};
+
+// Plays greedy El-Tetris while the stack is safe, and searches one piece
+// deeper for every danger threshold that boardDanger reaches, so the average
+// cost per piece stays close to greedy. Keeps the time spent at each depth.
+class AdaptiveDepth {
+public:
+  static constexpr int maxDepth = 4;
+
+  struct DepthStats {
+    long decisions = 0;
+    long nodes = 0;
+    double micros = 0;
+  };
+
+private:
+  MoveSet moves;
+  std::vector<int> danger;
+  std::array<DepthStats, maxDepth+1> stats {};
+
+public:
+  explicit AdaptiveDepth(const PlayerOptions &options = {}): moves(options.moves), danger(options.danger) {}
+
+  template <typename B>
+  int depth(const B &board) const {
+    int level = boardDanger(board);
+    int depth = 1;
+    for (auto threshold : danger) depth += level >= threshold;
+    return std::min(depth, maxDepth);
+  }
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) {
+    auto start = std::chrono::steady_clock::now();
+
+    int d = depth(board);
+    long nodes = 0;
+    auto move = d == 1 ? elTetris(board, piece, moves) : elTetrisExpectimax(board, piece, d, moves, nodes);
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    stats[d].decisions++;
+    stats[d].nodes += nodes;
+    stats[d].micros += elapsed.count();
+
+    return move;
+  }
+
+  void report(std::ostream &out) const {
+    out << "depth,decisions,total_ms,us_per_decision,nodes_per_decision" << std::endl;
+    for (int d = 1; d <= maxDepth; d++) {
+      const auto &s = stats[d];
+      if (s.decisions == 0) continue;
+      // The greedy path does not count nodes.
+      out << d << "," << s.decisions << "," << s.micros/1000 << "," << s.micros/s.decisions << ",";
+      if (d > 1) out << (double)s.nodes/s.decisions;
+      out << std::endl;
+    }
+  }
+};
+
+#endif
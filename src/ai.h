@@ -1,6 +1,11 @@
 #ifndef _AI_H_
 #define _AI_H_
 
+#include "movegen.h"
+
+#include <string>
+#include <vector>
+
 struct Evaluation {
   double score;
   bool valid;
@@ -13,4 +18,31 @@ struct Evaluation {
   }
 };
 
+// Command line knobs for players that take more than the move set. Players
+// with a constructor from PlayerOptions get all of them, others are built as
+// Player{moves}.
+struct PlayerOptions {
+  MoveSet moves = MoveSet::HardDrops;
+
+  // Threads for players that search in parallel, 0 for one per hardware
+  // thread.
+  int threads = 0;
+
+  // Danger levels at which the adaptive player searches one piece deeper.
+  std::vector<int> danger = { 10, 16 };
+
+  // Time the anytime player has for each move, in microseconds.
+  int budget = 1000;
+
+  // Pieces the expectimax players look at, including the current one.
+  int depth = 3;
+
+  // Opening book the book player reads, see book.h.
+  std::string book;
+
+  // Name of the game's randomizer, for players that simulate the pieces to
+  // come (see montecarlo.h).
+  std::string randomizer;
+};
+
 #endif
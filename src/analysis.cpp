@@ -0,0 +1,177 @@
+#include "analysis.h"
+#include "eltetris.h"
+#include "yiyuan.h"
+#include "dellacherie.h"
+#include "bcts.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 64K records are 2.6MB of input and 5MB of results, large enough for
+// sequential I/O and small enough for both result buffers to stay in cache.
+constexpr size_t chunkRecords = 1 << 16;
+
+// Records a thread takes at a time, so handing them out costs nothing next
+// to evaluating them.
+constexpr size_t blockRecords = 256;
+
+template <typename E>
+static void analyze(const E &evaluator, const AnalysisQuery &query, MoveSet moves, AnalysisResult &result) {
+  static_assert(E::size <= maxAnalysisFeatures, "too many features for AnalysisResult");
+
+  result = {};
+  result.col = result.rot = result.row = -1;
+  result.features = E::size;
+  if (query.piece > Z) return;
+
+  std::array<Board::Row, Board::height()> rows;
+  std::copy(query.rows, query.rows + Board::height(), rows.begin());
+  if (!Board::validRows(rows)) return;
+
+  Board board(rows);
+  auto piece = PieceType(query.piece);
+
+  IncrementalEvaluator<E, Board> candidates(evaluator, board);
+  auto best = bestMove(candidates, piece, moves).first;
+  if (!best.valid()) return;
+
+  auto next = board;
+  auto played = next.playMove(piece, best);
+  auto values = evaluator.values(next, played);
+
+  result.col = played.col;
+  result.rot = played.rot;
+  result.row = played.row;
+  result.score = evaluator.score(values);
+  std::copy(values.begin(), values.end(), result.values);
+}
+
+static bool writeAll(int fd, const void *data, size_t size) {
+  auto bytes = static_cast<const char *>(data);
+  for (size_t done = 0; done < size; ) {
+    ssize_t n = write(fd, bytes+done, size-done);
+    if (n <= 0) return false;
+    done += n;
+  }
+  return true;
+}
+
+// Advises the kernel about the pages of records [begin, end), rounded inwards
+// to whole pages.
+static void adviseRecords(const AnalysisQuery *queries, size_t begin, size_t end, int advice) {
+  static const uintptr_t page = sysconf(_SC_PAGESIZE);
+
+  auto first = (reinterpret_cast<uintptr_t>(queries + begin) + page-1) & ~(page-1);
+  auto last = reinterpret_cast<uintptr_t>(queries + end) & ~(page-1);
+  if (first < last) madvise(reinterpret_cast<void *>(first), last-first, advice);
+}
+
+template <typename E>
+static bool analyzeFile(const E &evaluator, const AnalysisQuery *queries, size_t count, int output,
+                        MoveSet moves, int threads) {
+  std::vector<AnalysisResult> buffers[2] = {
+    std::vector<AnalysisResult>(chunkRecords), std::vector<AnalysisResult>(chunkRecords)
+  };
+  std::future<bool> pending;
+  bool ok = true;
+
+  for (size_t begin = 0, chunk = 0; begin < count && ok; begin += chunkRecords, chunk++) {
+    size_t end = std::min(count, begin + chunkRecords);
+    adviseRecords(queries, end, std::min(count, end + chunkRecords), MADV_WILLNEED);
+
+    auto &results = buffers[chunk % 2];
+    int blocks = (end - begin + blockRecords-1) / blockRecords;
+    parallelFor(blocks, threads,
+        [&](int block, int) {
+          size_t first = begin + block*blockRecords;
+          size_t last = std::min(end, first + blockRecords);
+          for (size_t k = first; k < last; k++) analyze(evaluator, queries[k], moves, results[k-begin]);
+        });
+
+    adviseRecords(queries, begin, end, MADV_DONTNEED);
+
+    if (pending.valid()) ok = pending.get();
+    pending = std::async(std::launch::async, writeAll, output, results.data(), (end-begin)*sizeof(AnalysisResult));
+  }
+
+  if (pending.valid()) ok = pending.get() && ok;
+  return ok;
+}
+
+int runAnalysis(const std::string &input, const std::string &output, const std::string &ai,
+                MoveSet moves, int threads) {
+  if (ai != "eltetris" && ai != "yiyuan" && ai != "dellacherie" && ai != "bcts") {
+    std::cerr << "analyze needs an evaluator ai (eltetris, yiyuan, dellacherie or bcts)" << std::endl;
+    return 1;
+  }
+
+  int in = open(input.c_str(), O_RDONLY);
+  if (in < 0) {
+    std::cerr << "could not open " << input << ": " << strerror(errno) << std::endl;
+    return 1;
+  }
+
+  struct stat info;
+  if (fstat(in, &info) != 0 || info.st_size % sizeof(AnalysisQuery) != 0) {
+    std::cerr << input << " is not a whole number of " << sizeof(AnalysisQuery) << "-byte records" << std::endl;
+    close(in);
+    return 1;
+  }
+
+  size_t count = info.st_size / sizeof(AnalysisQuery);
+  const AnalysisQuery *queries = nullptr;
+  if (count > 0) {
+    void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, in, 0);
+    if (mapped == MAP_FAILED) {
+      std::cerr << "could not map " << input << ": " << strerror(errno) << std::endl;
+      close(in);
+      return 1;
+    }
+    madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+    queries = static_cast<const AnalysisQuery *>(mapped);
+  }
+  close(in);
+
+  int out = open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out < 0) {
+    std::cerr << "could not open " << output << ": " << strerror(errno) << std::endl;
+    if (queries != nullptr) munmap(const_cast<AnalysisQuery *>(queries), info.st_size);
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  bool ok = true;
+  if (ai == "eltetris") ok = analyzeFile(elTetrisEvaluator, queries, count, out, moves, threads);
+  if (ai == "yiyuan") ok = analyzeFile(yiyuanEvaluator, queries, count, out, moves, threads);
+  if (ai == "dellacherie") ok = analyzeFile(dellacherieEvaluator, queries, count, out, moves, threads);
+  if (ai == "bcts") ok = analyzeFile(bctsEvaluator, queries, count, out, moves, threads);
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  ok = close(out) == 0 && ok;
+  if (queries != nullptr) munmap(const_cast<AnalysisQuery *>(queries), info.st_size);
+
+  if (!ok) {
+    std::cerr << "could not write " << output << std::endl;
+    return 1;
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "records=" << count << ", threads=" << defaultThreads(threads)
+    << ", seconds=" << elapsed.count()
+    << ", records_per_second=" << (elapsed.count() > 0 ? count / elapsed.count() : 0.0) << std::endl;
+  return 0;
+}
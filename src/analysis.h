@@ -0,0 +1,55 @@
+#ifndef _ANALYSIS_H_
+#define _ANALYSIS_H_
+
+#include "tetris.h"
+#include "movegen.h"
+
+#include <cstdint>
+#include <string>
+
+// Offline analysis of recorded positions: -m analyze reads a file of
+// AnalysisQuery records and writes one AnalysisResult per record, in the
+// same order, both in native byte order.
+//
+// The input is memory-mapped and processed in chunks of chunkRecords
+// records, each split between the threads. The pages of a chunk are dropped
+// once it is done and the next chunk is prefetched, so files larger than
+// memory stream through. Results are written from two alternating buffers,
+// one chunk per write, by a writer that runs while the next chunk is being
+// evaluated.
+
+struct AnalysisQuery {
+  // Board rows from the top down, bit 0 being the leftmost cell, as in
+  // src/tetrisai.h.
+  uint16_t rows[Board::height()];
+  uint8_t piece;
+  uint8_t reserved;
+};
+
+static_assert(sizeof(AnalysisQuery) == 42, "AnalysisQuery is a file format");
+
+constexpr int maxAnalysisFeatures = 8;
+
+struct AnalysisResult {
+  // The best placement, with row where the top of the piece lands, or -1 in
+  // all three if the piece cannot be placed or the record is invalid (as
+  // for tetrisai_query).
+  int8_t col, rot, row;
+  // Number of entries of values in use, in the order the AI declares its
+  // features.
+  int8_t features;
+  uint32_t reserved;
+  double score;
+  // Feature values of the afterstate.
+  double values[maxAnalysisFeatures];
+};
+
+static_assert(sizeof(AnalysisResult) == 80, "AnalysisResult is a file format");
+
+// Analyses input into output with one of the evaluator AIs (eltetris, yiyuan,
+// dellacherie or bcts). Returns non-zero on errors, which are reported on
+// stderr.
+int runAnalysis(const std::string &input, const std::string &output, const std::string &ai,
+                MoveSet moves, int threads);
+
+#endif
@@ -0,0 +1,15 @@
+#include "anytime.h"
+#include "eltetris.h"
+#include "search.h"
+
+template <typename B>
+AnytimeMove elTetrisAnytime(const B &board, PieceType piece, int maxDepth,
+                            std::chrono::steady_clock::time_point deadline, MoveSet moves) {
+  ExpectimaxSearch<decltype(elTetrisEvaluator), B> search(elTetrisEvaluator, 4, moves);
+  auto result = search.deepen(board, piece, maxDepth, deadline);
+  return { result.move, result.depth, search.nodes };
+}
+
+#define INSTANTIATE(B) \
+  template AnytimeMove elTetrisAnytime(const B &board, PieceType piece, int maxDepth, std::chrono::steady_clock::time_point deadline, MoveSet moves);
+FOR_EACH_BOARD(INSTANTIATE)
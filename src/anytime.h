@@ -0,0 +1,87 @@
+#ifndef _ANYTIME_H_
+#define _ANYTIME_H_
+
+#include "tetris.h"
+#include "ai.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+
+struct AnytimeMove {
+  DropMove move;
+  int depth;
+  long nodes;
+};
+
+// El-Tetris expectimax deepened one piece at a time until the deadline,
+// see ExpectimaxSearch::deepen.
+template <typename B>
+AnytimeMove elTetrisAnytime(const B &board, PieceType piece, int maxDepth,
+                            std::chrono::steady_clock::time_point deadline, MoveSet moves);
+
+// Answers every move within PlayerOptions::budget microseconds with the
+// deepest search that finished in time. Keeps the depths reached and a
+// latency histogram in power-of-two microsecond buckets.
+class Anytime {
+public:
+  static constexpr int maxDepth = 8;
+  static constexpr int buckets = 24;
+
+private:
+  MoveSet moves;
+  int budget;
+
+  std::array<long, maxDepth+1> depths {};
+  std::array<long, buckets> latency {};
+  long decisions = 0, nodes = 0, overBudget = 0;
+  double maxMicros = 0;
+
+  // Time kept back for noticing the deadline between clock reads and
+  // unwinding the search.
+  int margin() const {
+    return std::max(budget/10, 10);
+  }
+
+public:
+  explicit Anytime(const PlayerOptions &options = {}): moves(options.moves), budget(options.budget) {}
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) {
+    auto start = std::chrono::steady_clock::now();
+    auto result = elTetrisAnytime(board, piece, maxDepth, start + std::chrono::microseconds(budget - margin()), moves);
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    decisions++;
+    nodes += result.nodes;
+    depths[result.depth]++;
+
+    int bucket = 0;
+    while (bucket < buckets-1 && elapsed.count() >= double(1 << bucket)) bucket++;
+    latency[bucket]++;
+    overBudget += elapsed.count() > budget;
+    maxMicros = std::max(maxMicros, elapsed.count());
+
+    return result.move;
+  }
+
+  void report(std::ostream &out) const {
+    out << "budget_us=" << budget << ", decisions=" << decisions
+      << ", nodes_per_decision=" << (decisions > 0 ? (double)nodes/decisions : 0) << std::endl;
+
+    out << "depth,decisions" << std::endl;
+    for (int d = 1; d <= maxDepth; d++) {
+      if (depths[d] > 0) out << d << "," << depths[d] << std::endl;
+    }
+
+    // Latencies below each bound, down to the bucket before.
+    out << "latency_below_us,decisions" << std::endl;
+    for (int b = 0; b < buckets; b++) {
+      if (latency[b] > 0) out << (1 << b) << "," << latency[b] << std::endl;
+    }
+    out << "over_budget=" << overBudget << ", max_us=" << maxMicros << std::endl;
+  }
+};
+
+#endif
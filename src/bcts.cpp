@@ -0,0 +1,16 @@
+#include "bcts.h"
+
+template <typename B>
+DropMove bcts(const B &board, PieceType piece, MoveSet moves) {
+  return greedyMove(bctsEvaluator, board, piece, moves);
+}
+
+template <typename B>
+DropMove bctsHold(const B &board, PieceType piece, PieceType held, MoveSet moves) {
+  return greedyHoldMove(bctsEvaluator, board, piece, held, moves);
+}
+
+#define INSTANTIATE(B) \
+  template DropMove bcts(const B &board, PieceType piece, MoveSet moves); \
+  template DropMove bctsHold(const B &board, PieceType piece, PieceType held, MoveSet moves);
+FOR_EACH_BOARD(INSTANTIATE)
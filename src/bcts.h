@@ -0,0 +1,40 @@
+#ifndef _BCTS_H_
+#define _BCTS_H_
+
+#include "tetris.h"
+#include "evaluator.h"
+
+// Building Controllers for Tetris (Thiery & Scherrer): Dellacherie's features
+// plus hole depth and rows with holes, with weights learned by cross-entropy.
+constexpr auto bctsEvaluator = makeEvaluator(
+  weighted<LandingHeight>(-12.63),
+  weighted<ErodedPieceCells>(6.60),
+  weighted<RowTransitions>(-9.22),
+  weighted<ColTransitions>(-19.77),
+  weighted<Holes>(-13.08),
+  weighted<WellSums>(-10.49),
+  weighted<HoleDepth>(-1.61),
+  weighted<RowsWithHoles>(-24.04));
+
+template <typename B>
+DropMove bcts(const B &board, PieceType piece, MoveSet moves = MoveSet::HardDrops);
+
+// Plays whichever of piece and held scores higher.
+template <typename B>
+DropMove bctsHold(const B &board, PieceType piece, PieceType held, MoveSet moves = MoveSet::HardDrops);
+
+struct Bcts {
+  MoveSet moves = MoveSet::HardDrops;
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) const {
+    return bcts(board, piece, moves);
+  }
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece, PieceType held) const {
+    return bctsHold(board, piece, held, moves);
+  }
+};
+
+#endif
@@ -0,0 +1,360 @@
+#include "bench.h"
+#include "randomizers.h"
+#include "rowkernels.h"
+#include "movegen.h"
+#include "perfectclear.h"
+#include "eltetris.h"
+#include "yiyuan.h"
+#include "tetrisai.h"
+#include "mirror.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <set>
+#include <tuple>
+
+std::vector<Board> boardCorpus(int seed, int count) {
+  std::vector<Board> corpus;
+  corpus.reserve(count);
+
+  for (int game = 0; (int)corpus.size() < count; game++) {
+    Board board;
+    SevenBagRandomizer sevenBag(seed+game);
+    NesRandomizer nes(seed+game);
+
+    for (int i = 0; i < 2000 && (int)corpus.size() < count; i++) {
+      auto piece = game % 2 == 0 ? sevenBag() : nes();
+      auto move = (game/2) % 2 == 0 ? elTetris(board, piece) : yiyuan(board, piece);
+      if (!move.valid() || !board.playMove(piece, move).valid()) break;
+
+      corpus.push_back(board);
+    }
+  }
+
+  return corpus;
+}
+
+struct RowKernelResult {
+  long transitions, holes, wellSums;
+  double transitionsNs, holesNs, wellSumsNs;
+};
+
+template <typename Fn>
+double timePerBoard(const std::vector<Board> &corpus, int passes, long &sum, Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+
+  sum = 0;
+  for (int pass = 0; pass < passes; pass++) {
+    for (const auto &board : corpus) sum += fn(board);
+  }
+
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  sum /= passes;
+  return elapsed.count() / ((double)passes * corpus.size());
+}
+
+template <typename K>
+RowKernelResult benchKernels(const std::vector<Board> &corpus, int passes) {
+  RowKernelResult r;
+  r.transitionsNs = timePerBoard(corpus, passes, r.transitions,
+      [](const Board &b) { return rowTransitions<K>(b); });
+  r.holesNs = timePerBoard(corpus, passes, r.holes,
+      [](const Board &b) { return rowHoles<K>(b); });
+  r.wellSumsNs = timePerBoard(corpus, passes, r.wellSums,
+      [](const Board &b) { return rowWellSums<K>(b); });
+  return r;
+}
+
+int benchRowKernels(int seed, int count) {
+  auto corpus = boardCorpus(seed, count);
+  int passes = std::max(1, 2000000 / (int)corpus.size());
+
+  std::cout << "boards=" << corpus.size() << ", passes=" << passes << std::endl;
+  std::cout << "kernel,row_transitions_ns,holes_ns,well_sums_ns" << std::endl;
+
+  const std::vector<std::pair<std::string, RowKernelResult>> results = {
+    { "cellloop", benchKernels<CellLoopRowKernels<10>>(corpus, passes) },
+    { "bitwise", benchKernels<BitwiseRowKernels<10>>(corpus, passes) },
+    { "table", benchKernels<TableRowKernels<10>>(corpus, passes) },
+    { "mixed", benchKernels<MixedRowKernels<10>>(corpus, passes) },
+  };
+
+  int mismatches = 0;
+  const auto &expected = results[0].second;
+
+  std::cout << std::fixed << std::setprecision(2);
+  for (const auto &result : results) {
+    const auto &r = result.second;
+    std::cout << result.first << "," << r.transitionsNs << "," << r.holesNs << "," << r.wellSumsNs << std::endl;
+
+    if (r.transitions != expected.transitions || r.holes != expected.holes || r.wellSums != expected.wellSums) {
+      std::cerr << result.first << " disagrees with cellloop" << std::endl;
+      mismatches++;
+    }
+  }
+
+  return mismatches > 0 ? 1 : 0;
+}
+
+template <typename B>
+long perft(const B &board, const std::vector<PieceType> &pieces, int depth, MoveSet moves) {
+  if (depth == 0) return 1;
+
+  long leaves = 0;
+  enumerateMoves(board, pieces[pieces.size()-depth], moves,
+      [&](DropMove move) {
+        B next = board;
+        if (next.playMove(pieces[pieces.size()-depth], move).valid()) {
+          leaves += depth == 1 ? 1 : perft(next, pieces, depth-1, moves);
+        }
+      });
+  return leaves;
+}
+
+// Placements as (rot, row, col), which both generators should agree on.
+using Placements = std::set<std::tuple<int, int, int>>;
+
+static bool placements(const Board &board, PieceType piece, MoveSet moves, Placements &out) {
+  bool ok = true;
+  enumerateMoves(board, piece, moves,
+      [&](DropMove move) {
+        int row = board.getDropRow(piece, move);
+        if (row < 0) return;
+        ok = out.insert({ move.rot, row, move.col }).second && ok;
+      });
+  return ok;
+}
+
+int benchMoveGen(int seed, int count, int depth) {
+  SevenBagRandomizer sevenBag(seed);
+  std::vector<PieceType> pieces(depth);
+  for (auto &piece : pieces) piece = sevenBag();
+
+  std::cout << "depth,hard_drop_leaves,hard_drop_ms,reachable_leaves,reachable_ms" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+
+  for (int d = 1; d <= depth; d++) {
+    std::vector<PieceType> prefix(pieces.begin(), pieces.begin()+d);
+    std::cout << d;
+
+    for (auto moves : { MoveSet::HardDrops, MoveSet::Reachable }) {
+      auto start = std::chrono::steady_clock::now();
+      auto leaves = perft(Board(), prefix, d, moves);
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << "," << leaves << "," << elapsed.count();
+    }
+    std::cout << std::endl;
+  }
+
+  auto corpus = boardCorpus(seed, count);
+  int failures = 0;
+
+  for (const auto &board : corpus) {
+    for (int p = 0; p < 7; p++) {
+      Placements dropped, reached;
+      if (!placements(board, PieceType(p), MoveSet::Reachable, reached)) {
+        failures++;
+        std::cerr << "duplicate reachable placement" << std::endl;
+      }
+      placements(board, PieceType(p), MoveSet::HardDrops, dropped);
+
+      for (const auto &placement : dropped) {
+        if (reached.count(placement) == 0) {
+          failures++;
+          std::cerr << "hard drop not reachable" << std::endl;
+        }
+      }
+    }
+  }
+
+  int passes = std::max(1, 200000 / (int)corpus.size());
+  std::cout << "boards=" << corpus.size() << ", passes=" << passes << std::endl;
+  std::cout << "moves,moves_per_piece,mean_row,us_per_piece" << std::endl;
+
+  // Each move is resolved to its landing row, as a search does before
+  // evaluating it, and only those that land count. Hard drop enumeration
+  // alone never looks at the board.
+  for (auto moves : { MoveSet::HardDrops, MoveSet::Reachable }) {
+    long generated = 0, rowSum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+      for (const auto &board : corpus) {
+        for (int p = 0; p < 7; p++) {
+          enumerateMoves(board, PieceType(p), moves, [&](DropMove move) {
+            int row = board.getDropRow(PieceType(p), move);
+            if (row < 0) return;
+            generated++;
+            rowSum += row;
+          });
+        }
+      }
+    }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << (moves == MoveSet::HardDrops ? "harddrop" : "reachable") << ","
+      << (double)generated / (7.0*passes*corpus.size()) << ","
+      << (double)rowSum / generated << ","
+      << elapsed.count() / (7.0*passes*corpus.size()) << std::endl;
+  }
+
+  return failures > 0 ? 1 : 0;
+}
+
+int benchPerfectClear(int seed, int count, int pieces, MoveSet moves, int threads) {
+  PerfectClearOptions options;
+  options.moves = moves;
+  options.threads = threads;
+
+  std::cout << "threads=" << defaultThreads(threads) << ", pieces=" << pieces << std::endl;
+  std::cout << "seed,found,length,nodes,ms" << std::endl;
+
+  int found = 0;
+  long nodes = 0;
+  double totalMs = 0;
+
+  for (int i = 0; i < count; i++) {
+    SevenBagRandomizer sevenBag(seed+i);
+    std::vector<PieceType> sequence(pieces);
+    for (auto &piece : sequence) piece = sevenBag();
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = findPerfectClear(Board(), sequence, options);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    // Replay the solution to make sure it is one.
+    Board board;
+    for (int k = 0; k < (int)result.moves.size(); k++) {
+      if (!board.playMove(sequence[k], result.moves[k]).valid()) {
+        std::cerr << "seed " << seed+i << ": invalid move in solution" << std::endl;
+        return 1;
+      }
+    }
+    if (result.found() && board.stackHeight() != 0) {
+      std::cerr << "seed " << seed+i << ": solution does not clear the board" << std::endl;
+      return 1;
+    }
+
+    found += result.found();
+    nodes += result.nodes;
+    totalMs += elapsed.count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << seed+i << "," << result.found() << "," << result.moves.size() << ","
+      << result.nodes << "," << elapsed.count() << std::endl;
+  }
+
+  std::cout << "found=" << found << "/" << count << ", nodes=" << nodes
+    << ", ms_per_search=" << totalMs/count << std::endl;
+  return 0;
+}
+
+int benchLibrary(int seed, int count) {
+  auto corpus = boardCorpus(seed, count);
+  int passes = std::max(1, 200000 / (int)corpus.size());
+
+  SevenBagRandomizer sevenBag(seed);
+  std::vector<uint16_t> rows(corpus.size() * TETRISAI_HEIGHT);
+  std::vector<uint8_t> pieces(corpus.size());
+  for (size_t k = 0; k < corpus.size(); k++) {
+    for (int i = 0; i < Board::height(); i++) rows[k*TETRISAI_HEIGHT + i] = corpus[k].row(i);
+    pieces[k] = sevenBag();
+  }
+
+  auto engine = tetrisai_create(TETRISAI_ELTETRIS, nullptr, TETRISAI_HARD_DROPS);
+  std::vector<tetrisai_move> moves(corpus.size());
+  std::vector<DropMove> expected(corpus.size(), DropMove::invalid());
+
+  std::cout << "boards=" << corpus.size() << ", passes=" << passes << std::endl;
+  std::cout << "call,ns_per_query" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+
+  auto time = [&](const char *name, auto &&fn) {
+    fn();
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) fn();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << "," << elapsed.count() / ((double)passes * corpus.size()) << std::endl;
+  };
+
+  time("direct", [&]() {
+    for (size_t k = 0; k < corpus.size(); k++) expected[k] = elTetris(corpus[k], PieceType(pieces[k]));
+  });
+  time("query", [&]() {
+    for (size_t k = 0; k < corpus.size(); k++) tetrisai_query(engine, &rows[k*TETRISAI_HEIGHT], pieces[k], &moves[k]);
+  });
+  time("batch", [&]() {
+    tetrisai_query_batch(engine, rows.data(), pieces.data(), corpus.size(), moves.data());
+  });
+
+  tetrisai_destroy(engine);
+
+  int mismatches = 0;
+  for (size_t k = 0; k < corpus.size(); k++) {
+    const auto &move = moves[k];
+    if (move.col != expected[k].col || move.rot != expected[k].rot ||
+        move.row != corpus[k].getDropRow(PieceType(pieces[k]), expected[k])) {
+      mismatches++;
+    }
+  }
+
+  if (mismatches > 0) std::cerr << mismatches << " queries disagree with elTetris" << std::endl;
+  return mismatches > 0 ? 1 : 0;
+}
+
+// Score of playing move on board with the evaluator, scored from scratch.
+template <typename E>
+static double placementScore(const E &evaluator, const Board &board, PieceType piece, DropMove move) {
+  auto after = board;
+  auto played = after.playMove(piece, move);
+  return played.valid() ? evaluator.score(after, played) : -1e300;
+}
+
+template <typename E, typename Fn>
+static int checkMirrorFor(const char *name, const E &evaluator, Fn ai, const std::vector<Board> &corpus) {
+  long decisions = 0, sameMove = 0, failures = 0;
+
+  for (const auto &board : corpus) {
+    auto image = mirrorBoard(board);
+    if (mirrorBoard(image) != board) failures++;
+
+    for (int p = 0; p < 7; p++) {
+      auto piece = PieceType(p);
+      auto mirrored = mirrorPiece(piece);
+
+      auto move = ai(board, piece);
+      auto imageMove = ai(image, mirrored);
+      decisions++;
+
+      // Ties between placements may be broken differently on the two sides,
+      // but the best scores have to agree, and the mirror image of a move has
+      // to score the same as the move.
+      auto score = placementScore(evaluator, board, piece, move);
+      auto imageScore = placementScore(evaluator, image, mirrored, imageMove);
+      auto reflected = placementScore(evaluator, image, mirrored, mirrorMove<Board::width()>(piece, move));
+      if (std::abs(score - imageScore) > 1e-9 || std::abs(score - reflected) > 1e-9) failures++;
+
+      sameMove += mirrorMove<Board::width()>(piece, move) == imageMove;
+
+      auto a = canonical(board, piece), b = canonical(image, mirrored);
+      if (a.board != b.board || a.piece != b.piece) failures++;
+    }
+  }
+
+  std::cout << name << "," << decisions << "," << sameMove << "," << failures << std::endl;
+  return failures > 0 ? 1 : 0;
+}
+
+int checkMirror(int seed, int count) {
+  auto corpus = boardCorpus(seed, count);
+  std::cout << "boards=" << corpus.size() << std::endl;
+  std::cout << "ai,decisions,same_move,failures" << std::endl;
+
+  int failed = 0;
+  failed |= checkMirrorFor("eltetris", elTetrisEvaluator,
+      [](const Board &board, PieceType piece) { return elTetris(board, piece); }, corpus);
+  failed |= checkMirrorFor("yiyuan", yiyuanEvaluator,
+      [](const Board &board, PieceType piece) { return yiyuan(board, piece); }, corpus);
+  return failed;
+}
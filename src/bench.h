@@ -0,0 +1,39 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include "tetris.h"
+#include "movegen.h"
+
+#include <vector>
+
+// Boards seen while simulating games with both AIs under the 7bag and NES
+// randomizers, so the corpus has clean stacks as well as messy ones.
+std::vector<Board> boardCorpus(int seed, int count);
+
+// Compares the row kernels in rowkernels.h on the
+// row features of boardCorpus(seed, count). Returns non-zero if they disagree.
+int benchRowKernels(int seed, int count);
+
+// Perft for the move generators in movegen.h: counts the leaves of the move
+// tree to the given depth from an empty board, playing the 7bag sequence for
+// seed, then times generation over boardCorpus(seed, count) and checks that
+// every hard drop is among the reachable placements. Returns non-zero if a
+// check fails.
+int benchMoveGen(int seed, int count, int depth);
+
+// Searches for perfect clears from an empty board with count sequences of
+// pieces pieces each, from 7bag games seeded seed, seed+1, ...
+int benchPerfectClear(int seed, int count, int pieces, MoveSet moves, int threads);
+
+// Times El-Tetris on boardCorpus(seed, count) called directly, through
+// tetrisai_query and through tetrisai_query_batch (see src/tetrisai.h).
+// Returns non-zero if the C interface disagrees with the direct calls.
+int benchLibrary(int seed, int count);
+
+// Checks on boardCorpus(seed, count) that El-Tetris and Yiyuan decide mirror
+// images alike (see mirror.h): the best placement on the mirrored board
+// scores the same as the best one on the board, and so does the mirror image
+// of the latter. Returns non-zero if a check fails.
+int checkMirror(int seed, int count);
+
+#endif
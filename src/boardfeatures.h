@@ -0,0 +1,166 @@
+#ifndef _BOARDFEATURES_H_
+#define _BOARDFEATURES_H_
+
+#include "tetris.h"
+#include "rowkernels.h"
+
+#include <cstdlib>
+
+// Board features used by evaluator.h. Each feature is one of:
+//
+// - Move: computed from the Move that produced the afterstate
+// - Row: a sum of row(r) over every row
+// - Column: a sum of column(j, left, c, right) over every column, where the
+//   walls count as full columns
+// - Board: anything else, computed from the whole FeatureContext
+//
+// Row and Column features are what allow an evaluator to score a candidate by
+// revisiting only the rows and columns the piece touched.
+
+enum class FeatureKind { Move, Row, Column, Board };
+
+// Intermediate results shared by every feature of an evaluator, computed once
+// per afterstate.
+template <typename B>
+struct FeatureContext {
+  using Column = BoardColumn<B::height()>;
+
+  const B &board;
+  std::array<Column, B::width()> columns;
+};
+
+// Single column kernels. Columns are bottom-up words, see BoardColumn.
+
+template <typename C>
+inline int columnHeight(C c) {
+  return bitLength(c);
+}
+
+// Empty cells under the top of the column.
+template <typename C>
+inline C columnHoles(C c) {
+  return ~c & ((C(1) << bitLength(c))-1);
+}
+
+struct LinesCleared {
+  static constexpr auto kind = FeatureKind::Move;
+
+  template <typename B>
+  static double move(const Move &move) {
+    return move.linesCleared;
+  }
+};
+
+// Height of the middle of the piece that was just placed.
+struct LandingHeight {
+  static constexpr auto kind = FeatureKind::Move;
+
+  template <typename B>
+  static double move(const Move &move) {
+    int pieceHeight = pieceShape(move.piece, move.rot).height;
+    return B::height()-move.row + ((pieceHeight-1)/2.0);
+  }
+};
+
+// Lines cleared times the number of the piece's own cells they removed.
+struct ErodedPieceCells {
+  static constexpr auto kind = FeatureKind::Move;
+
+  template <typename B>
+  static double move(const Move &move) {
+    return move.linesCleared * move.erodedCells;
+  }
+};
+
+// Filled/empty changes along each row, walls counting as filled.
+struct RowTransitions {
+  static constexpr auto kind = FeatureKind::Row;
+
+  template <typename B>
+  static int row(typename B::Row r) {
+    return DefaultRowKernels<B::width()>::transitions(r);
+  }
+};
+
+// Filled/empty changes down each column, the floor counting as filled.
+struct ColTransitions {
+  static constexpr auto kind = FeatureKind::Column;
+
+  template <typename B, typename C>
+  static int column(int j, C left, C c, C right) {
+    return bitCount((c ^ ((c << 1) | 1)) & B::fullColumn);
+  }
+};
+
+// Empty cells with a filled cell anywhere above them.
+struct Holes {
+  static constexpr auto kind = FeatureKind::Column;
+
+  template <typename B, typename C>
+  static int column(int j, C left, C c, C right) {
+    return bitLength(c)-bitCount(c);
+  }
+};
+
+// Each well cell (empty, with both neighbours filled) counts itself plus the
+// run of empty cells below it.
+struct WellSums {
+  static constexpr auto kind = FeatureKind::Column;
+
+  template <typename B, typename C>
+  static int column(int j, C left, C c, C right) {
+    int sums = 0;
+    for (C wells = ~c & left & right; wells != 0; wells &= wells-1) {
+      int bit = lowestBit(wells);
+      sums += 1+bit-bitLength(c & ((C(1) << bit)-1));
+    }
+    return sums;
+  }
+};
+
+struct AggregateHeight {
+  static constexpr auto kind = FeatureKind::Column;
+
+  template <typename B, typename C>
+  static int column(int j, C left, C c, C right) {
+    return columnHeight(c);
+  }
+};
+
+// Sum of height differences between adjacent columns.
+struct Bumpiness {
+  static constexpr auto kind = FeatureKind::Column;
+
+  template <typename B, typename C>
+  static int column(int j, C left, C c, C right) {
+    return j > 0 ? abs(columnHeight(c)-columnHeight(left)) : 0;
+  }
+};
+
+// Filled cells above each hole, summed over holes.
+struct HoleDepth {
+  static constexpr auto kind = FeatureKind::Column;
+
+  template <typename B, typename C>
+  static int column(int j, C left, C c, C right) {
+    int depth = 0;
+    for (C holes = columnHoles(c); holes != 0; holes &= holes-1) {
+      depth += bitCount(C(c >> lowestBit(holes)));
+    }
+    return depth;
+  }
+};
+
+// Rows with at least one hole.
+struct RowsWithHoles {
+  static constexpr auto kind = FeatureKind::Board;
+
+  template <typename B>
+  static int board(const FeatureContext<B> &context) {
+    typename FeatureContext<B>::Column rows = 0;
+    for (auto c : context.columns) rows |= columnHoles(c);
+    return bitCount(rows);
+  }
+};
+
+#endif
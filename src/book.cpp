@@ -0,0 +1,93 @@
+#include "book.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+OpeningBook::OpeningBook(const std::string &path) {
+  if (path.empty()) return;
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(BookHeader)) {
+    close(fd);
+    return;
+  }
+
+  void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) return;
+
+  BookHeader read;
+  memcpy(&read, mapped, sizeof(read));
+  auto capacity = read.capacity;
+  if (memcmp(read.magic, BookHeader::expectedMagic, sizeof(read.magic)) != 0 ||
+      read.version != BookHeader::currentVersion ||
+      capacity == 0 || (capacity & (capacity-1)) != 0 || read.entries > capacity/2 ||
+      (size_t)info.st_size != sizeof(BookHeader) + capacity*sizeof(BookEntry)) {
+    munmap(mapped, info.st_size);
+    return;
+  }
+
+  // Lookups jump around the table.
+  madvise(mapped, info.st_size, MADV_RANDOM);
+
+  header = read;
+  mapping = mapped;
+  length = info.st_size;
+  entries = reinterpret_cast<const BookEntry *>(static_cast<const char *>(mapped) + sizeof(BookHeader));
+}
+
+OpeningBook::~OpeningBook() {
+  if (mapping != nullptr) munmap(mapping, length);
+}
+
+bool writeBook(const std::string &path, int width, int height, int pieces, bool mirrored,
+               const std::unordered_map<uint64_t, DropMove> &moves) {
+  uint64_t capacity = 16;
+  while (capacity < 2*moves.size()) capacity *= 2;
+
+  std::vector<BookEntry> table(capacity);
+  for (const auto &[key, move] : moves) {
+    auto slot = key & (capacity-1);
+    while (table[slot].key != 0) slot = (slot+1) & (capacity-1);
+
+    auto &entry = table[slot];
+    entry.key = key;
+    entry.col = move.col;
+    entry.rot = move.rot;
+    entry.row = move.row;
+  }
+
+  BookHeader header {};
+  memcpy(header.magic, BookHeader::expectedMagic, sizeof(header.magic));
+  header.version = BookHeader::currentVersion;
+  header.width = width;
+  header.height = height;
+  header.pieces = pieces;
+  header.flags = mirrored ? BookHeader::mirrored : 0;
+  header.capacity = capacity;
+  header.entries = moves.size();
+
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+
+  bool ok = true;
+  auto writeAll = [&](const void *data, size_t size) {
+    auto bytes = static_cast<const char *>(data);
+    for (size_t done = 0; ok && done < size; ) {
+      ssize_t n = write(fd, bytes+done, size-done);
+      if (n <= 0) ok = false;
+      else done += n;
+    }
+  };
+
+  writeAll(&header, sizeof(header));
+  writeAll(table.data(), table.size()*sizeof(BookEntry));
+  return close(fd) == 0 && ok;
+}
@@ -0,0 +1,247 @@
+#ifndef _BOOK_H_
+#define _BOOK_H_
+
+#include "tetris.h"
+#include "ai.h"
+#include "parallel.h"
+#include "mirror.h"
+#include "compactboard.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Opening books: the moves an AI plays in every position reachable in the
+// first few pieces of a game, computed ahead of time (possibly by a search
+// too slow to run live) and stored in a hash table on disk.
+//
+// A book file is a BookHeader followed by capacity BookEntry slots, a power
+// of two at most half full, with linear probing from key & (capacity-1). An
+// entry is keyed by bookKey of the board and piece alone, so one entry serves
+// every sequence that reaches the position. Empty slots have key 0. Books of
+// hard drops are keyed on the canonical form of the position (see mirror.h),
+// so a position and its mirror image share an entry, and the move is stored
+// for the canonical form.
+//
+// OpeningBook maps the file and only reads the header, so opening a book
+// takes the same time whatever its size, and a lookup touches one or two
+// pages of it.
+
+struct BookHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t width, height;
+  // Pieces from the start of a game the book covers.
+  uint32_t pieces;
+  uint32_t flags;
+  uint32_t reserved;
+  uint64_t capacity;
+  uint64_t entries;
+
+  static constexpr char expectedMagic[8] = "TBOOK";
+  static constexpr uint32_t currentVersion = 3;
+
+  // Keys and moves are for the canonical form of positions.
+  static constexpr uint32_t mirrored = 1;
+};
+
+static_assert(sizeof(BookHeader) == 48, "BookHeader is a file format");
+
+struct BookEntry {
+  uint64_t key;
+  int8_t col, rot, row;
+  uint8_t reserved[5];
+};
+
+static_assert(sizeof(BookEntry) == 16, "BookEntry is a file format");
+
+inline uint64_t mixBits(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// Hash of the board, as a CompactBoard, and the piece, never 0.
+template <typename B>
+uint64_t bookKey(const B &board, PieceType piece) {
+  uint64_t key = mixBits(BasicCompactBoard<B>(board).hash() + mixBits(piece + 1));
+  return key != 0 ? key : 1;
+}
+
+class OpeningBook {
+private:
+  void *mapping = nullptr;
+  size_t length = 0;
+  const BookEntry *entries = nullptr;
+
+  bool find(uint64_t key, DropMove &move) const {
+    auto mask = header.capacity-1;
+    for (auto slot = key & mask; entries[slot].key != 0; slot = (slot+1) & mask) {
+      const auto &entry = entries[slot];
+      if (entry.key == key) {
+        move = DropMove(entry.col, entry.rot, entry.row);
+        return true;
+      }
+    }
+    return false;
+  }
+
+public:
+  BookHeader header {};
+
+  explicit OpeningBook(const std::string &path);
+  ~OpeningBook();
+
+  OpeningBook(const OpeningBook &) = delete;
+  OpeningBook &operator=(const OpeningBook &) = delete;
+
+  bool ok() const { return mapping != nullptr; }
+
+  // The book's move for piece on board, if it has one and the book is for
+  // boards of this size.
+  template <typename B>
+  bool lookup(const B &board, PieceType piece, DropMove &move) const {
+    if (!ok() || header.width != B::width() || header.height != B::height()) return false;
+
+    if ((header.flags & BookHeader::mirrored) == 0) return find(bookKey(board, piece), move);
+
+    auto position = canonical(board, piece);
+    if (!find(bookKey(position.board, position.piece), move)) return false;
+    move = position.original(move);
+    return true;
+  }
+};
+
+// Writes moves, keyed by bookKey, as a book for W x H boards covering the
+// given number of pieces, with keys and moves for canonical forms if
+// mirrored. Returns false if the file could not be written.
+bool writeBook(const std::string &path, int width, int height, int pieces, bool mirrored,
+               const std::unordered_map<uint64_t, DropMove> &moves);
+
+struct BookBuild {
+  long positions = 0;
+  long decisions = 0;
+};
+
+// Plays every sequence of pieces pieces from an empty board with players made
+// by makePlayer(), one per thread, and collects their move for each
+// position. With sevenBag, only sequences the 7-bag randomizer can deal are
+// followed, otherwise any piece can follow any other. Positions are merged
+// whatever sequence reached them, and with mirrored, with their mirror
+// images: players are only asked about canonical forms, and only one of
+// each mirrored pair of (board, bag) states is followed.
+template <typename B, typename MakePlayer>
+BookBuild buildBook(int pieces, bool sevenBag, bool mirrored, int threads, MakePlayer makePlayer,
+                    std::unordered_map<uint64_t, DropMove> &moves) {
+  struct State {
+    B board;
+    uint8_t bag;
+  };
+
+  struct Task {
+    int state;
+    PieceType piece;
+    Canonical<B> position;
+    uint64_t key;
+  };
+
+  BookBuild build;
+  threads = defaultThreads(threads);
+  std::vector<decltype(makePlayer())> players;
+  for (int t = 0; t < threads; t++) players.push_back(makePlayer());
+
+  std::vector<State> states = { { B(), 0 } };
+  for (int ply = 0; ply < pieces && !states.empty(); ply++) {
+    std::vector<Task> tasks, decide;
+    for (int s = 0; s < (int)states.size(); s++) {
+      for (int p = 0; p < 7; p++) {
+        if (sevenBag && (states[s].bag >> p) & 1) continue;
+
+        const auto &board = states[s].board;
+        auto position = mirrored ? canonical(board, PieceType(p)) : Canonical<B>{ board, PieceType(p), false };
+        auto key = bookKey(position.board, position.piece);
+        tasks.push_back({ s, PieceType(p), position, key });
+        if (moves.emplace(key, DropMove::invalid()).second) decide.push_back(tasks.back());
+      }
+    }
+
+    std::vector<DropMove> decided(decide.size(), DropMove::invalid());
+    parallelFor((int)decide.size(), threads,
+        [&](int i, int thread) {
+          decided[i] = players[thread](decide[i].position.board, decide[i].position.piece);
+        });
+    for (size_t i = 0; i < decide.size(); i++) moves.at(decide[i].key) = decided[i];
+    build.decisions += decide.size();
+
+    std::vector<State> next;
+    std::unordered_set<uint64_t> seen;
+    for (const auto &task : tasks) {
+      auto move = task.position.original(moves.at(task.key));
+      if (!move.valid()) continue;
+
+      const auto &state = states[task.state];
+      State after = { state.board, uint8_t(sevenBag ? state.bag | (1 << task.piece) : 0) };
+      if (after.bag == 0x7f) after.bag = 0;
+      if (!after.board.playMove(task.piece, move).valid()) continue;
+
+      if (mirrored) {
+        State image = { mirrorBoard(after.board), mirrorBag(after.bag) };
+        if (mirrorIsCanonical(after.board, I) || (image.board == after.board && image.bag < after.bag)) {
+          after = image;
+        }
+      }
+
+      if (seen.insert(mixBits(bookKey(after.board, I) + after.bag)).second) next.push_back(after);
+    }
+
+    build.positions += states.size();
+    states = std::move(next);
+  }
+
+  for (auto it = moves.begin(); it != moves.end(); ) {
+    it = it->second.valid() ? std::next(it) : moves.erase(it);
+  }
+  return build;
+}
+
+// Plays the book's move for as long as the game is within the pieces the
+// book covers and the position is in it, and leaves the rest to Fallback.
+template <typename Fallback>
+class OpeningBookPlayer {
+private:
+  Fallback fallback;
+  std::shared_ptr<const OpeningBook> book;
+  long pieces = 0, lookups = 0, hits = 0;
+
+public:
+  explicit OpeningBookPlayer(const PlayerOptions &options = {}):
+    fallback{options.moves}, book(std::make_shared<OpeningBook>(options.book)) {
+    if (!options.book.empty() && !book->ok()) std::cerr << "could not open book " << options.book << std::endl;
+  }
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) {
+    if (pieces++ < book->header.pieces) {
+      lookups++;
+
+      DropMove move = DropMove::invalid();
+      if (book->lookup(board, piece, move) && board.getDropRow(piece, move) >= 0) {
+        hits++;
+        return move;
+      }
+    }
+
+    return fallback(board, piece);
+  }
+
+  void report(std::ostream &out) const {
+    out << "book_pieces=" << book->header.pieces << ", book_entries=" << book->header.entries
+      << ", lookups=" << lookups << ", hits=" << hits << std::endl;
+  }
+};
+
+#endif
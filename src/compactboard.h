@@ -0,0 +1,83 @@
+#ifndef _COMPACTBOARD_H_
+#define _COMPACTBOARD_H_
+
+#include "tetris.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+
+// A board packed into as few 64-bit words as its rows fit in, for search
+// nodes and tables where many boards are kept around. Rows are stored
+// bottom-up, 64/W of them per word (six 10-bit rows for the standard board,
+// which takes 32 bytes), and the top byte of the last word holds the stack
+// height so it can be read without unpacking. If the rows leave no room for
+// it, the height gets a word of its own.
+template <typename B>
+class BasicCompactBoard {
+public:
+  static constexpr int rowsPerWord = 64/B::width();
+  static constexpr int rowWords = (B::height()+rowsPerWord-1)/rowsPerWord;
+  static constexpr int wordCount =
+    rowWords + ((B::height()-(rowWords-1)*rowsPerWord)*B::width() > 56 ? 1 : 0);
+
+private:
+  std::array<uint64_t, wordCount> words;
+
+public:
+  BasicCompactBoard(): words({}) {}
+
+  explicit BasicCompactBoard(const B &board): words({}) {
+    int stackHeight = board.stackHeight();
+    for (int k = 0; k < stackHeight; k++) {
+      words[k/rowsPerWord] |= uint64_t(board.row(B::height()-1-k)) << ((k%rowsPerWord)*B::width());
+    }
+    words[wordCount-1] |= uint64_t(stackHeight) << 56;
+  }
+
+  B toBoard() const {
+    std::array<typename B::Row, B::height()> rows {};
+    int stackHeight = height();
+    for (int k = 0; k < stackHeight; k++) {
+      rows[B::height()-1-k] = (words[k/rowsPerWord] >> ((k%rowsPerWord)*B::width())) & B::fullRow;
+    }
+    return B(rows);
+  }
+
+  int height() const { return words[wordCount-1] >> 56; }
+
+  // The first word alone, without the height: the bottom rowsPerWord rows,
+  // which tells boards no taller than that apart in a single word.
+  static uint64_t bottomWord(const B &board) {
+    uint64_t word = 0;
+    int rows = std::min(board.stackHeight(), rowsPerWord);
+    for (int k = 0; k < rows; k++) word |= uint64_t(board.row(B::height()-1-k)) << (k*B::width());
+    return word;
+  }
+
+  uint64_t hash() const {
+    uint64_t h = 0;
+    for (auto w : words) {
+      h = (h ^ w) * 0x9e3779b97f4a7c15ull;
+      h ^= h >> 32;
+    }
+    return h;
+  }
+
+  bool operator==(const BasicCompactBoard &b) const { return words == b.words; }
+  bool operator!=(const BasicCompactBoard &b) const { return words != b.words; }
+};
+
+using CompactBoard = BasicCompactBoard<Board>;
+
+static_assert(sizeof(CompactBoard) == 32, "CompactBoard should be 32 bytes");
+
+namespace std {
+  template <typename B>
+  struct hash<BasicCompactBoard<B>> {
+    size_t operator()(const BasicCompactBoard<B> &b) const { return b.hash(); }
+  };
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef _CYCLES_H_
+#define _CYCLES_H_
+
+#include "game.h"
+#include "compactboard.h"
+
+#include <cstdint>
+#include <optional>
+
+// Finds the cycle a game of a stateless player falls into, if any, with
+// Brent's algorithm: the State after piece 2^k is kept as a checkpoint, and
+// every State up to piece 2^(k+1) is compared against it. Once the
+// checkpoint is inside a cycle no longer than 2^k pieces, the game returns
+// to it within one cycle, so a cycle of length L entered after M pieces is
+// found within a few times max(M, L) pieces, keeping a single State.
+//
+// The randomizers have a bounded state (the NES LFSR repeats after 32767
+// steps, and the others after 2^31 draws of their engine), so every such
+// game either ends or cycles, though mostly after far longer than it is
+// worth waiting for. What makes it worth looking is the NES randomizer: its
+// state is short, and an AI that keeps a low stack revisits the same boards.
+//
+// Each State is first compared by a hash of the board (as a CompactBoard),
+// the held piece and the preview, and only compared in full, randomizer
+// included, when that matches.
+template <typename G>
+class CycleDetector {
+private:
+  std::optional<typename G::State> checkpoint;
+  uint64_t checkpointHash = 0;
+  GameStats checkpointStats;
+  long power = 1, distance = 0;
+
+  static uint64_t hash(const typename G::State &state) {
+    uint64_t h = BasicCompactBoard<decltype(state.board)>(state.board).hash();
+    auto mix = [&](uint64_t v) {
+      h = (h ^ v) * 0x9e3779b97f4a7c15ull;
+      h ^= h >> 32;
+    };
+
+    mix(state.held);
+    for (int i = 0; i < state.preview.count; i++) mix(state.preview.pieces[i] + 8);
+    return h;
+  }
+
+public:
+  // Length of the cycle once found, in pieces, and 0 until then.
+  int length = 0;
+
+  // Stats of the game when the cycle was last at its start, so the stats of
+  // one cycle are the difference between them and the stats when found.
+  const GameStats &cycleStart() const { return checkpointStats; }
+
+  // Call after every piece played. Returns true when the game is back in the
+  // State it was in length pieces ago.
+  bool step(const G &game) {
+    static_assert(G::stateless, "only games of stateless players repeat");
+
+    auto state = game.state();
+    auto h = hash(state);
+    distance++;
+
+    if (checkpoint && h == checkpointHash && game.inState(*checkpoint)) {
+      length = distance;
+      return true;
+    }
+
+    if (distance == power) {
+      checkpoint = std::move(state);
+      checkpointHash = h;
+      checkpointStats = game.stats();
+      power *= 2;
+      distance = 0;
+    }
+    return false;
+  }
+};
+
+#endif
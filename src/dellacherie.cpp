@@ -0,0 +1,16 @@
+#include "dellacherie.h"
+
+template <typename B>
+DropMove dellacherie(const B &board, PieceType piece, MoveSet moves) {
+  return greedyMove(dellacherieEvaluator, board, piece, moves);
+}
+
+template <typename B>
+DropMove dellacherieHold(const B &board, PieceType piece, PieceType held, MoveSet moves) {
+  return greedyHoldMove(dellacherieEvaluator, board, piece, held, moves);
+}
+
+#define INSTANTIATE(B) \
+  template DropMove dellacherie(const B &board, PieceType piece, MoveSet moves); \
+  template DropMove dellacherieHold(const B &board, PieceType piece, PieceType held, MoveSet moves);
+FOR_EACH_BOARD(INSTANTIATE)
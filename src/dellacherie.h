@@ -0,0 +1,38 @@
+#ifndef _DELLACHERIE_H_
+#define _DELLACHERIE_H_
+
+#include "tetris.h"
+#include "evaluator.h"
+
+// Pierre Dellacherie's hand-tuned weights, which El-Tetris later re-tuned
+// (El-Tetris uses lines cleared in place of eroded piece cells).
+constexpr auto dellacherieEvaluator = makeEvaluator(
+  weighted<LandingHeight>(-1),
+  weighted<ErodedPieceCells>(1),
+  weighted<RowTransitions>(-1),
+  weighted<ColTransitions>(-1),
+  weighted<Holes>(-4),
+  weighted<WellSums>(-1));
+
+template <typename B>
+DropMove dellacherie(const B &board, PieceType piece, MoveSet moves = MoveSet::HardDrops);
+
+// Plays whichever of piece and held scores higher.
+template <typename B>
+DropMove dellacherieHold(const B &board, PieceType piece, PieceType held, MoveSet moves = MoveSet::HardDrops);
+
+struct Dellacherie {
+  MoveSet moves = MoveSet::HardDrops;
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) const {
+    return dellacherie(board, piece, moves);
+  }
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece, PieceType held) const {
+    return dellacherieHold(board, piece, held, moves);
+  }
+};
+
+#endif
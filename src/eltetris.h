@@ -2,7 +2,35 @@
 #define _ELTETRIS_H_
 
 #include "tetris.h"
+#include "evaluator.h"
 
-DropMove elTetris(const Board &board, PieceType piece);
+constexpr auto elTetrisEvaluator = makeEvaluator(
+  weighted<LinesCleared>(3.4181268101392694),
+  weighted<LandingHeight>(-4.500158825082766),
+  weighted<RowTransitions>(-3.2178882868487753),
+  weighted<ColTransitions>(-9.348695305445199),
+  weighted<Holes>(-7.899265427351652),
+  weighted<WellSums>(-3.3855972247263626));
+
+template <typename B>
+DropMove elTetris(const B &board, PieceType piece, MoveSet moves = MoveSet::HardDrops);
+
+// Plays whichever of piece and held scores higher.
+template <typename B>
+DropMove elTetrisHold(const B &board, PieceType piece, PieceType held, MoveSet moves = MoveSet::HardDrops);
+
+struct ElTetris {
+  MoveSet moves = MoveSet::HardDrops;
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) const {
+    return elTetris(board, piece, moves);
+  }
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece, PieceType held) const {
+    return elTetrisHold(board, piece, held, moves);
+  }
+};
 
 #endif
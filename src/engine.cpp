@@ -0,0 +1,158 @@
+#include "engine.h"
+#include "bench.h"
+#include "randomizers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+bool EngineIO::readLine(const char *&line, size_t &length) {
+  for (;;) {
+    auto newline = static_cast<char *>(memchr(&in[begin], '\n', end-begin));
+    if (newline != nullptr) {
+      line = &in[begin];
+      length = newline - &in[begin];
+      if (length > 0 && line[length-1] == '\r') length--;
+      begin = newline - &in[0] + 1;
+      return true;
+    }
+
+    // Only block once everything answered so far is on its way.
+    flush();
+
+    if (begin > 0) {
+      memmove(&in[0], &in[begin], end-begin);
+      end -= begin;
+      begin = 0;
+    }
+
+    // A line longer than the buffer is dropped.
+    if (end == in.size()) end = 0;
+
+    ssize_t n = read(input, &in[end], in.size()-end);
+    if (n <= 0) return false;
+    end += n;
+  }
+}
+
+void EngineIO::write(const char *text, size_t length) {
+  if (written + length > out.size()) flush();
+  memcpy(&out[written], text, length);
+  written += length;
+}
+
+void EngineIO::flush() {
+  for (size_t done = 0; done < written; ) {
+    ssize_t n = ::write(output, &out[done], written-done);
+    if (n <= 0) break;
+    done += n;
+  }
+  written = 0;
+}
+
+using Clock = std::chrono::steady_clock;
+
+static double microsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+int runLoadGenerator(const char *self, const std::string &ai, const std::string &moves,
+                     int seed, int count, const PlayerFunc &player) {
+  auto corpus = boardCorpus(seed, count);
+  StreamRandomizer pieces(seed);
+
+  std::vector<PieceType> queryPieces;
+  std::vector<char> queries;
+  std::vector<size_t> offsets;
+  char query[4 + Board::height()*hexDigitsPerRow<Board>()];
+
+  for (const auto &board : corpus) {
+    auto piece = pieces();
+    queryPieces.push_back(piece);
+    offsets.push_back(queries.size());
+
+    size_t n = formatQuery(query, board, piece);
+    queries.insert(queries.end(), query, query+n);
+  }
+  offsets.push_back(queries.size());
+
+  // The AI on its own.
+  auto start = Clock::now();
+  for (size_t i = 0; i < corpus.size(); i++) player(corpus[i], queryPieces[i]);
+  double directMicros = microsSince(start);
+
+  int toEngine[2], fromEngine[2];
+  if (pipe(toEngine) != 0 || pipe(fromEngine) != 0) {
+    std::cerr << "could not create pipes" << std::endl;
+    return 1;
+  }
+
+  pid_t child = fork();
+  if (child == 0) {
+    dup2(toEngine[0], 0);
+    dup2(fromEngine[1], 1);
+    close(toEngine[0]); close(toEngine[1]);
+    close(fromEngine[0]); close(fromEngine[1]);
+    execl(self, self, "-m", "engine", "-a", ai.c_str(), "-M", moves.c_str(), (char *)nullptr);
+    _exit(127);
+  }
+  close(toEngine[0]);
+  close(fromEngine[1]);
+
+  EngineIO io(fromEngine[0], toEngine[1]);
+  const char *line;
+  size_t length;
+  long answered = 0;
+
+  // Round trips, one query in flight.
+  start = Clock::now();
+  for (size_t i = 0; i < corpus.size(); i++) {
+    io.write(&queries[offsets[i]], offsets[i+1]-offsets[i]);
+    io.flush();
+    answered += io.readLine(line, length);
+  }
+  double roundTripMicros = microsSince(start);
+
+  // Everything at once, written from another thread so neither side waits
+  // on a full pipe.
+  start = Clock::now();
+  std::thread writer([&] {
+    for (size_t done = 0; done < queries.size(); ) {
+      ssize_t n = write(toEngine[1], &queries[done], queries.size()-done);
+      if (n <= 0) break;
+      done += n;
+    }
+  });
+  for (size_t i = 0; i < corpus.size(); i++) answered += io.readLine(line, length);
+  writer.join();
+  double pipelinedMicros = microsSince(start);
+
+  io.write("quit\n");
+  io.flush();
+  close(toEngine[1]);
+  close(fromEngine[0]);
+  waitpid(child, nullptr, 0);
+
+  if (answered != 2*(long)corpus.size()) {
+    std::cerr << "engine answered " << answered << " of " << 2*corpus.size() << " queries" << std::endl;
+    return 1;
+  }
+
+  double n = corpus.size();
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "ai=" << ai << ", queries=" << corpus.size() << std::endl;
+  std::cout << "direct_us=" << directMicros/n << std::endl;
+  std::cout << "round_trip_us=" << roundTripMicros/n
+    << ", overhead_us=" << (roundTripMicros-directMicros)/n << std::endl;
+  std::cout << "pipelined_us=" << pipelinedMicros/n
+    << ", overhead_us=" << (pipelinedMicros-directMicros)/n
+    << ", queries_per_s=" << n/(pipelinedMicros/1e6) << std::endl;
+
+  return 0;
+}
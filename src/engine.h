@@ -0,0 +1,182 @@
+#ifndef _ENGINE_H_
+#define _ENGINE_H_
+
+#include "tetris.h"
+
+#include <array>
+#include <cstring>
+#include <string>
+
+// Headless engine protocol, one request per line on stdin and one answer per
+// line on stdout, in order:
+//
+//   q <piece> [rows]  Best move for piece (one of IOTLJSZ) on the board.
+//                     rows is the board from the bottom row up, (W+3)/4 hex
+//                     digits per row with bit 0 the leftmost cell; rows
+//                     left out are empty. Boards with a full row or an
+//                     empty row under a filled one are a bad query.
+//                     Answer: <col> <rot> <row>, row being where the top of
+//                     the piece lands, or "none" if it cannot be placed.
+//   ai <name>         Switch AI. Answer: "ok", or "error <message>".
+//   isready           Answer: "readyok", once everything before it is done.
+//   quit              Stop.
+//
+// Anything else is answered with "error <message>". Requests can be sent
+// without waiting for answers. Answers are buffered and only written out
+// when no complete request is left to read, so a pipelined burst costs one
+// read and one write system call, and no request allocates.
+
+class EngineIO {
+private:
+  std::array<char, 1 << 16> in;
+  std::array<char, 1 << 16> out;
+  size_t begin = 0, end = 0, written = 0;
+  int input, output;
+
+public:
+  EngineIO(int input = 0, int output = 1): input(input), output(output) {}
+
+  // Next line without its newline, or false at the end of the input. The
+  // line stays valid until the next call.
+  bool readLine(const char *&line, size_t &length);
+
+  void write(const char *text, size_t length);
+  void write(const char *text) { write(text, strlen(text)); }
+  void flush();
+};
+
+constexpr const char *pieceNames = "IOTLJSZ";
+
+template <typename B>
+constexpr int hexDigitsPerRow() {
+  return (B::width()+3)/4;
+}
+
+// Writes "q <piece> <rows>" and a newline into text, returning its length.
+// text needs room for 4 + H*(W+3)/4 characters.
+template <typename B>
+size_t formatQuery(char *text, const B &board, PieceType piece) {
+  static constexpr char hex[] = "0123456789abcdef";
+
+  size_t n = 0;
+  text[n++] = 'q';
+  text[n++] = ' ';
+  text[n++] = pieceNames[piece];
+
+  int rows = board.stackHeight();
+  if (rows > 0) text[n++] = ' ';
+  for (int k = 0; k < rows; k++) {
+    auto row = board.row(B::height()-1-k);
+    for (int d = hexDigitsPerRow<B>()-1; d >= 0; d--) text[n++] = hex[(row >> (4*d)) & 0xf];
+  }
+
+  text[n++] = '\n';
+  return n;
+}
+
+// Parses the arguments of a q request, after "q ".
+template <typename B>
+bool parseQuery(const char *text, size_t length, B &board, PieceType &piece) {
+  if (length < 1) return false;
+
+  auto name = strchr(pieceNames, text[0]);
+  if (text[0] == '\0' || name == nullptr) return false;
+  piece = PieceType(name - pieceNames);
+
+  std::array<typename B::Row, B::height()> rows {};
+  size_t i = 1;
+  while (i < length && text[i] == ' ') i++;
+
+  constexpr int digits = hexDigitsPerRow<B>();
+  if ((length-i) % digits != 0 || (length-i)/digits > (size_t)B::height()) return false;
+
+  for (int k = 0; i < length; k++) {
+    typename B::Row row = 0;
+    for (int d = 0; d < digits; d++, i++) {
+      char c = text[i];
+      int v = c >= '0' && c <= '9' ? c-'0' : c >= 'a' && c <= 'f' ? c-'a'+10 : c >= 'A' && c <= 'F' ? c-'A'+10 : -1;
+      if (v < 0) return false;
+      row = (row << 4) | v;
+    }
+    rows[B::height()-1-k] = row;
+  }
+
+  if (!B::validRows(rows)) return false;
+  board = B(rows);
+  return true;
+}
+
+// Writes a non-negative or -1 number, returning its length.
+inline size_t formatInt(char *text, int value) {
+  if (value < 0) {
+    text[0] = '-';
+    return 1 + formatInt(text+1, -value);
+  }
+
+  char digits[12];
+  size_t n = 0;
+  do {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0);
+
+  for (size_t i = 0; i < n; i++) text[i] = digits[n-1-i];
+  return n;
+}
+
+// Answers requests with player until the input ends, a quit, or an ai
+// request. Returns the name asked for by the ai request, or an empty string
+// to stop.
+template <typename B, typename Player>
+std::string runEngine(EngineIO &io, Player &player) {
+  const char *line;
+  size_t length;
+  char answer[64];
+
+  while (io.readLine(line, length)) {
+    if (length >= 2 && line[0] == 'q' && line[1] == ' ') {
+      B board;
+      PieceType piece;
+      if (!parseQuery(line+2, length-2, board, piece)) {
+        io.write("error bad query\n");
+        continue;
+      }
+
+      auto move = player(board, piece);
+      int row = move.valid() ? board.getDropRow(piece, move) : -1;
+      if (row < 0) {
+        io.write("none\n");
+        continue;
+      }
+
+      size_t n = formatInt(answer, move.col);
+      answer[n++] = ' ';
+      n += formatInt(answer+n, move.rot);
+      answer[n++] = ' ';
+      n += formatInt(answer+n, row);
+      answer[n++] = '\n';
+      io.write(answer, n);
+    } else if (length > 3 && strncmp(line, "ai ", 3) == 0) {
+      return std::string(line+3, length-3);
+    } else if (length == 7 && strncmp(line, "isready", 7) == 0) {
+      io.write("readyok\n");
+    } else if (length == 4 && strncmp(line, "quit", 4) == 0) {
+      break;
+    } else if (length > 0) {
+      io.write("error unknown request\n");
+    }
+  }
+
+  io.flush();
+  return std::string();
+}
+
+// Load generator for the engine: starts `self -m engine -a ai -M moves` as a
+// child process and sends it queries for boards from boardCorpus(seed,
+// count), first one at a time for round-trip latency, then pipelined for
+// throughput. Compares both against calling player directly on the same
+// queries, which is the AI's own share of the time.
+int runLoadGenerator(const char *self, const std::string &ai, const std::string &moves,
+                     int seed, int count, const PlayerFunc &player);
+
+#endif
@@ -0,0 +1,348 @@
+#ifndef _EVALUATOR_H_
+#define _EVALUATOR_H_
+
+#include "tetris.h"
+#include "ai.h"
+#include "boardfeatures.h"
+#include "movegen.h"
+
+#include <array>
+#include <tuple>
+#include <utility>
+
+// A feature from boardfeatures.h together with its weight.
+template <typename F>
+struct Weighted {
+  using Feature = F;
+  double weight;
+
+  constexpr explicit Weighted(double weight): weight(weight) {}
+};
+
+template <typename F>
+constexpr Weighted<F> weighted(double weight) {
+  return Weighted<F>(weight);
+}
+
+// A linear evaluator declared as a compile-time list of weighted features:
+//
+//   constexpr auto evaluator = makeEvaluator(
+//     weighted<LinesCleared>(1.0),
+//     weighted<Holes>(-4.0));
+//
+// values() computes every feature of an afterstate in one pass over its rows
+// and one over its columns, sharing the column words between them. The score
+// is the weighted sum in declaration order.
+template <typename... Terms>
+class Evaluator {
+public:
+  static constexpr int size = sizeof...(Terms);
+
+  static constexpr bool hasRowFeatures = ((Terms::Feature::kind == FeatureKind::Row) || ...);
+  static constexpr bool hasColumnFeatures = ((Terms::Feature::kind == FeatureKind::Column) || ...);
+  static constexpr bool hasBoardFeatures = ((Terms::Feature::kind == FeatureKind::Board) || ...);
+
+  // Without Board features, every feature is a sum over rows and columns, so
+  // candidates can be scored incrementally, see IncrementalEvaluator.
+  static constexpr bool incremental = !hasBoardFeatures;
+
+  using Values = std::array<double, size>;
+
+  std::tuple<Terms...> terms;
+
+  constexpr explicit Evaluator(Terms... terms): terms(terms...) {}
+
+  // Calls fn(index, term) for every term, in declaration order.
+  template <typename Fn>
+  void forEachTerm(Fn &&fn) const {
+    forEachTerm(fn, std::index_sequence_for<Terms...>());
+  }
+
+  double score(const Values &values) const {
+    double score = 0;
+    forEachTerm([&](auto index, const auto &term) {
+      score += values[index] * term.weight;
+    });
+    return score;
+  }
+
+  template <typename B>
+  Values values(const B &board, const Move &move) const;
+
+  template <typename B>
+  double score(const B &board, const Move &move) const {
+    return score(values(board, move));
+  }
+
+private:
+  template <typename Fn, size_t... Is>
+  void forEachTerm(Fn &fn, std::index_sequence<Is...>) const {
+    (fn(std::integral_constant<size_t, Is>(), std::get<Is>(terms)), ...);
+  }
+};
+
+template <typename... Terms>
+constexpr Evaluator<Terms...> makeEvaluator(Terms... terms) {
+  return Evaluator<Terms...>(terms...);
+}
+
+template <typename T>
+using FeatureOf = typename std::decay_t<T>::Feature;
+
+template <typename... Terms>
+template <typename B>
+typename Evaluator<Terms...>::Values Evaluator<Terms...>::values(const B &board, const Move &move) const {
+  using Column = typename FeatureContext<B>::Column;
+  constexpr bool needsColumns = hasColumnFeatures || hasBoardFeatures;
+
+  Values values {};
+  FeatureContext<B> context { board, {} };
+
+  // Rows above the stack are empty, so their row features are all the same.
+  int top = B::height()-board.stackHeight();
+
+  if constexpr (hasRowFeatures) {
+    forEachTerm([&](auto index, const auto &term) {
+      using F = FeatureOf<decltype(term)>;
+      if constexpr (F::kind == FeatureKind::Row) values[index] = top * F::template row<B>(0);
+    });
+  }
+
+  if constexpr (hasRowFeatures || (needsColumns && !B::hasColumns)) {
+    for (int i = top; i < B::height(); i++) {
+      auto r = board.row(i);
+
+      forEachTerm([&](auto index, const auto &term) {
+        using F = FeatureOf<decltype(term)>;
+        if constexpr (F::kind == FeatureKind::Row) values[index] += F::template row<B>(r);
+      });
+
+      if constexpr (needsColumns && !B::hasColumns) {
+        for (auto bits = r; bits != 0; bits &= bits-1) {
+          context.columns[lowestBit(bits)] |= Column(1) << (B::height()-1-i);
+        }
+      }
+    }
+  }
+
+  if constexpr (needsColumns && B::hasColumns) {
+    for (int j = 0; j < B::width(); j++) context.columns[j] = board.column(j);
+  }
+
+  if constexpr (hasColumnFeatures) {
+    const auto &columns = context.columns;
+    for (int j = 0; j < B::width(); j++) {
+      auto left = j > 0 ? columns[j-1] : B::fullColumn;
+      auto right = j < B::width()-1 ? columns[j+1] : B::fullColumn;
+
+      forEachTerm([&](auto index, const auto &term) {
+        using F = FeatureOf<decltype(term)>;
+        if constexpr (F::kind == FeatureKind::Column) {
+          values[index] += F::template column<B, Column>(j, left, columns[j], right);
+        }
+      });
+    }
+  }
+
+  forEachTerm([&](auto index, const auto &term) {
+    using F = FeatureOf<decltype(term)>;
+    if constexpr (F::kind == FeatureKind::Board) values[index] = F::template board<B>(context);
+    if constexpr (F::kind == FeatureKind::Move) values[index] = F::template move<B>(move);
+  });
+
+  return values;
+}
+
+// Scores placements of any piece against a fixed base board. The row and
+// column contributions of the base board are computed once, so a candidate
+// that clears no lines only revisits the rows and columns it touches (and the
+// neighbouring columns, which Column features may depend on). Placements that
+// clear lines shift every row, and fall back to a full evaluation, as does
+// every placement if the evaluator has Board features.
+template <typename E, typename B>
+class IncrementalEvaluator {
+private:
+  using Column = BoardColumn<B::height()>;
+  using Columns = std::array<Column, B::width()>;
+
+  const E &evaluator;
+  const B &board;
+
+  Columns columns;
+  std::array<std::array<int, B::height()>, E::size> rowValues;
+  std::array<std::array<int, B::width()>, E::size> columnValues;
+  typename E::Values totals;
+
+  template <typename F>
+  static int columnValue(const Columns &c, int j) {
+    auto left = j > 0 ? c[j-1] : B::fullColumn;
+    auto right = j < B::width()-1 ? c[j+1] : B::fullColumn;
+    return F::template column<B, Column>(j, left, c[j], right);
+  }
+
+public:
+  IncrementalEvaluator(const E &evaluator, const B &board);
+
+  const B &base() const { return board; }
+
+  // Copies the board and plays the move, then evaluates it from scratch.
+  Evaluation evaluateFull(PieceType piece, DropMove move) const;
+
+  Evaluation evaluate(PieceType piece, DropMove move) const;
+};
+
+template <typename E, typename B>
+IncrementalEvaluator<E, B>::IncrementalEvaluator(const E &evaluator, const B &board)
+  : evaluator(evaluator), board(board), columns({}), totals({}) {
+
+  if constexpr (E::incremental) {
+    for (int i = 0; i < B::height(); i++) {
+      auto r = board.row(i);
+
+      evaluator.forEachTerm([&](auto index, const auto &term) {
+        using F = FeatureOf<decltype(term)>;
+        if constexpr (F::kind == FeatureKind::Row) {
+          rowValues[index][i] = F::template row<B>(r);
+          totals[index] += rowValues[index][i];
+        }
+      });
+
+      if constexpr (!B::hasColumns) {
+        for (auto bits = r; bits != 0; bits &= bits-1) {
+          columns[lowestBit(bits)] |= Column(1) << (B::height()-1-i);
+        }
+      }
+    }
+
+    if constexpr (B::hasColumns) {
+      for (int j = 0; j < B::width(); j++) columns[j] = board.column(j);
+    }
+
+    for (int j = 0; j < B::width(); j++) {
+      evaluator.forEachTerm([&](auto index, const auto &term) {
+        using F = FeatureOf<decltype(term)>;
+        if constexpr (F::kind == FeatureKind::Column) {
+          columnValues[index][j] = columnValue<F>(columns, j);
+          totals[index] += columnValues[index][j];
+        }
+      });
+    }
+  }
+}
+
+template <typename E, typename B>
+Evaluation IncrementalEvaluator<E, B>::evaluateFull(PieceType piece, DropMove move) const {
+  auto updated = board;
+  auto overallMove = updated.playMove(piece, move);
+  if (!overallMove.valid()) return Evaluation::invalid();
+
+  return Evaluation(evaluator.score(updated, overallMove));
+}
+
+template <typename E, typename B>
+Evaluation IncrementalEvaluator<E, B>::evaluate(PieceType piece, DropMove move) const {
+  if constexpr (!E::incremental) return evaluateFull(piece, move);
+
+  if (!move.valid() || move.rot < 0 || move.rot >= pieceRotations(piece)) return Evaluation::invalid();
+
+  const auto &shape = pieceShape(piece, move.rot);
+  if (move.col + shape.width > B::width()) return Evaluation::invalid();
+
+  int dropRow = board.getDropRow(piece, move);
+  if (dropRow < 0) return Evaluation::invalid();
+
+  auto values = totals;
+
+  for (int i = 0; i < shape.height; i++) {
+    auto r = board.row(dropRow+i) | (typename B::Row(shape.rows[i]) << move.col);
+    if (r == B::fullRow) return evaluateFull(piece, move);
+
+    evaluator.forEachTerm([&](auto index, const auto &term) {
+      using F = FeatureOf<decltype(term)>;
+      if constexpr (F::kind == FeatureKind::Row) {
+        values[index] += F::template row<B>(r) - rowValues[index][dropRow+i];
+      }
+    });
+  }
+
+  if constexpr (E::hasColumnFeatures) {
+    auto updated = columns;
+    for (int i = 0; i < shape.height; i++) {
+      auto bit = Column(1) << (B::height()-1-dropRow-i);
+      for (uint16_t bits = shape.rows[i]; bits != 0; bits &= bits-1) {
+        updated[move.col + lowestBit(bits)] |= bit;
+      }
+    }
+
+    int first = move.col > 0 ? move.col-1 : 0;
+    int last = move.col+shape.width < B::width() ? move.col+shape.width : B::width()-1;
+    for (int j = first; j <= last; j++) {
+      evaluator.forEachTerm([&](auto index, const auto &term) {
+        using F = FeatureOf<decltype(term)>;
+        if constexpr (F::kind == FeatureKind::Column) {
+          values[index] += columnValue<F>(updated, j) - columnValues[index][j];
+        }
+      });
+    }
+  }
+
+  // No lines were cleared.
+  Move overallMove(piece, dropRow, move.col, move.rot, 0, 0);
+  evaluator.forEachTerm([&](auto index, const auto &term) {
+    using F = FeatureOf<decltype(term)>;
+    if constexpr (F::kind == FeatureKind::Move) values[index] = F::template move<B>(overallMove);
+  });
+
+  return Evaluation(evaluator.score(values));
+}
+
+// The placement of piece that scores highest against candidates' base board,
+// with its score.
+template <typename E, typename B>
+std::pair<DropMove, double> bestMove(const IncrementalEvaluator<E, B> &candidates, PieceType piece, MoveSet moves) {
+  double bestScore = -10000000000000000.0;
+  auto bestMove = DropMove::invalid();
+
+  enumerateMoves(candidates.base(), piece, moves,
+      [&](DropMove move) {
+        auto eval = candidates.evaluate(piece, move);
+        if (!eval.valid) return;
+
+        if (eval.score > bestScore) {
+          bestScore = eval.score;
+          bestMove = move;
+        }
+      });
+
+  return { bestMove, bestScore };
+}
+
+// Plays the placement of piece that the evaluator scores highest.
+template <typename E, typename B>
+DropMove greedyMove(const E &evaluator, const B &board, PieceType piece, MoveSet moves = MoveSet::HardDrops) {
+  IncrementalEvaluator<E, B> candidates(evaluator, board);
+  return bestMove(candidates, piece, moves).first;
+}
+
+// Like greedyMove, but may play the held piece instead. Both pieces are
+// scored against one IncrementalEvaluator, so the base board's row and column
+// values are only computed once per turn, and a held piece of the same type
+// is not searched twice. Ties keep the current piece.
+template <typename E, typename B>
+DropMove greedyHoldMove(const E &evaluator, const B &board, PieceType piece, PieceType held,
+                        MoveSet moves = MoveSet::HardDrops) {
+  IncrementalEvaluator<E, B> candidates(evaluator, board);
+
+  auto current = bestMove(candidates, piece, moves);
+  if (held == piece) return current.first;
+
+  auto swapped = bestMove(candidates, held, moves);
+  if (!swapped.first.valid() || (current.first.valid() && swapped.second <= current.second)) {
+    return current.first;
+  }
+
+  swapped.first.hold = true;
+  return swapped.first;
+}
+
+#endif
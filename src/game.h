@@ -0,0 +1,204 @@
+#ifndef _GAME_H_
+#define _GAME_H_
+
+#include "tetris.h"
+#include "trainingdata.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <iostream>
+#include <type_traits>
+
+struct GameStats {
+  int pieces;
+  int linesCleared;
+  int holds;
+  int perfectClears;
+  std::map<PieceType, int> pieceFrequency;
+
+  GameStats(): pieces(0), linesCleared(0), holds(0), perfectClears(0) {}
+
+  // Adds what was counted since earlier times over, as when a game repeats
+  // a cycle.
+  void repeat(const GameStats &earlier, int times) {
+    pieces += (pieces - earlier.pieces) * times;
+    linesCleared += (linesCleared - earlier.linesCleared) * times;
+    holds += (holds - earlier.holds) * times;
+    perfectClears += (perfectClears - earlier.perfectClears) * times;
+    for (auto &[piece, count] : pieceFrequency) {
+      auto before = earlier.pieceFrequency.find(piece);
+      count += (count - (before != earlier.pieceFrequency.end() ? before->second : 0)) * times;
+    }
+  }
+};
+
+// Distributions of the results of many games, in constant memory (see
+// stats.h). Merge the summaries of different threads with merge().
+struct GameSummary {
+  Distribution lines;
+  Distribution pieces;
+
+  void add(const GameStats &stats) {
+    lines.add(stats.linesCleared);
+    pieces.add(stats.pieces);
+  }
+
+  void merge(const GameSummary &other) {
+    lines.merge(other.lines);
+    pieces.merge(other.pieces);
+  }
+};
+
+// Game is deterministic state machine.
+// Given the same seed and randomizer, it should always produce the same sequence of pieces.
+//
+// Player and Randomizer are concrete callable types (e.g. ElTetris, SevenBagRandomizer),
+// so each combination compiles into its own specialised loop with no indirect calls.
+// Game<PlayerFunc, PieceGenerator> still works when the types are only known at runtime.
+// B selects the board dimensions, see BasicBoard.
+//
+// With hold enabled, the first piece drawn goes straight into the hold slot,
+// and every turn after that the player is called as player(board, piece,
+// held) and may play either piece (see DropMove::hold). Players without that
+// overload always play the current piece.
+//
+// With a preview of n pieces, the randomizer is kept n pieces ahead and
+// players with a (board, piece, const PiecePreview &) overload are shown
+// them. The preview takes precedence over hold for players with both.
+//
+// With a TrainingRecorder attached, every piece played is recorded, and a
+// game over ends the recorder's game.
+//
+// When the player's moves depend on nothing but the board, the pieces and
+// the held piece (deterministic, and with no state of its own), everything
+// after a tick is decided by State: the board, the randomizer, the held piece
+// and the preview. Two ticks that leave the game in the same State start the
+// same cycle, which fastForward() can skip over (see cycles.h).
+template <typename Player, typename Randomizer, typename B = Board>
+class Game {
+private:
+  int seed;
+  B board;
+  Move lastMove;
+  GameStats _stats;
+  Player player;
+  Randomizer nextPiece;
+  bool hold;
+  PieceType held;
+  PiecePreview preview;
+  TrainingRecorder *recorder = nullptr;
+
+  DropMove decide(PieceType piece) {
+    if constexpr (std::is_invocable_v<Player &, const B &, PieceType, const PiecePreview &>) {
+      if (preview.count > 0) return player(board, piece, preview);
+    }
+    if constexpr (std::is_invocable_v<Player &, const B &, PieceType, PieceType>) {
+      if (hold) return player(board, piece, held);
+    }
+    return player(board, piece);
+  }
+
+public:
+  enum TickResult { Ok, GameOver };
+
+  static constexpr bool stateless =
+    std::is_invocable_v<const Player &, const B &, PieceType> &&
+    std::is_invocable_v<const Player &, const B &, PieceType, PieceType> ==
+      std::is_invocable_v<Player &, const B &, PieceType, PieceType> &&
+    std::is_invocable_v<const Player &, const B &, PieceType, const PiecePreview &> ==
+      std::is_invocable_v<Player &, const B &, PieceType, const PiecePreview &>;
+
+  struct State {
+    B board;
+    Randomizer randomizer;
+    PieceType held;
+    PiecePreview preview;
+  };
+
+  Game(int seed, Player player, Randomizer randomizer, bool hold = false, int preview = 0):
+    seed(seed), player(std::move(player)), nextPiece(std::move(randomizer)), hold(hold), held(I) {
+    assert(preview <= PiecePreview::capacity);
+    if (hold) held = nextPiece();
+    for (this->preview.count = 0; this->preview.count < preview; this->preview.count++) {
+      this->preview.pieces[this->preview.count] = nextPiece();
+    }
+  }
+
+  const GameStats &stats() const { return _stats; }
+  const Player &currentPlayer() const { return player; }
+
+  void record(TrainingRecorder *recorder) { this->recorder = recorder; }
+
+  State state() const { return { board, nextPiece, held, preview }; }
+
+  bool inState(const State &s) const {
+    return board == s.board && nextPiece == s.randomizer && held == s.held &&
+      preview.count == s.preview.count &&
+      std::equal(&preview.pieces[0], &preview.pieces[preview.count], &s.preview.pieces[0]);
+  }
+
+  // Counts times more repeats of what was played since start, a cycle that
+  // has brought the game back to the State it was in then.
+  void fastForward(const GameStats &start, int times) {
+    static_assert(stateless, "only games of stateless players repeat");
+    _stats.repeat(start, times);
+  }
+
+  TickResult tick();
+  void print();
+};
+
+template <typename Player, typename Randomizer, typename B>
+typename Game<Player, Randomizer, B>::TickResult Game<Player, Randomizer, B>::tick() {
+  auto piece = nextPiece();
+  if (preview.count > 0) {
+    std::swap(piece, preview.pieces[0]);
+    std::rotate(&preview.pieces[0], &preview.pieces[1], &preview.pieces[preview.count]);
+  }
+
+  auto dropMove = decide(piece);
+
+  if (!dropMove.valid()) {
+    if (recorder != nullptr) recorder->endGame(true);
+    return GameOver;
+  }
+
+  if (hold && dropMove.hold) {
+    std::swap(piece, held);
+    _stats.holds++;
+  }
+
+  B before;
+  if (recorder != nullptr) before = board;
+
+  auto move = board.playMove(piece, dropMove);
+  if (!move.valid()) {
+    if (recorder != nullptr) recorder->endGame(true);
+    return GameOver;
+  }
+
+  if (recorder != nullptr) recorder->add(before, piece, dropMove, move, board);
+  lastMove = move;
+
+  _stats.linesCleared += lastMove.linesCleared;
+  if (move.linesCleared > 0 && board.stackHeight() == 0) _stats.perfectClears++;
+  _stats.pieces++;
+  _stats.pieceFrequency[piece]++;
+
+  return Ok;
+}
+
+template <typename Player, typename Randomizer, typename B>
+void Game<Player, Randomizer, B>::print() {
+  std::cout << "pieces=" << _stats.pieces;
+  std::cout << ", lines cleared=" << _stats.linesCleared;
+  if (hold) std::cout << ", holds=" << _stats.holds;
+  if (preview.count > 0) std::cout << ", perfect clears=" << _stats.perfectClears;
+  std::cout << std::endl;
+
+  board.print();
+}
+
+#endif
@@ -1,28 +1,239 @@
+#include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <variant>
 
 #include "tetris.h"
+#include "game.h"
 #include "randomizers.h"
 #include "argparse.hpp"
+#include "bench.h"
+#include "movegen.h"
 
 #include "eltetris.h"
 #include "yiyuan.h"
+#include "dellacherie.h"
+#include "bcts.h"
+#include "perfectclear.h"
+#include "montecarlo.h"
+#include "adaptive.h"
+#include "anytime.h"
+#include "speculative.h"
+#include "engine.h"
+#include "analysis.h"
+#include "book.h"
+#include "cycles.h"
+#include "tournament.h"
+#include "versus.h"
+
+// Maps below name types rather than functions. std::visit over them
+// instantiates runGame for every AI x randomizer x board combination.
+template <typename T>
+struct TypeTag {
+  using type = T;
+};
+
+using AnyPlayer = std::variant<
+  TypeTag<ElTetris>,
+  TypeTag<Yiyuan>,
+  TypeTag<Dellacherie>,
+  TypeTag<Bcts>,
+  TypeTag<PerfectClearPlayer<ElTetris>>,
+  TypeTag<MonteCarlo>,
+  TypeTag<AdaptiveDepth>,
+  TypeTag<Anytime>,
+  TypeTag<ElTetrisExpectimax>,
+  TypeTag<Speculative<ElTetrisExpectimax>>,
+  TypeTag<OpeningBookPlayer<ElTetris>>>;
+
+using AnyRandomizer = std::variant<
+  TypeTag<UniformRandomizer>,
+  TypeTag<NesRandomizer>,
+  TypeTag<NesApproxRandomizer>,
+  TypeTag<SevenBagRandomizer>>;
+
+using AnyBoard = std::variant<
+  TypeTag<Board>,
+  TypeTag<SpawnBoard>,
+  TypeTag<TallBoard>,
+  TypeTag<ColumnBoard>,
+  TypeTag<SpawnColumnBoard>,
+  TypeTag<TallColumnBoard>>;
+
+// Players with more options than the move set are built from PlayerOptions.
+template <typename Player>
+Player makePlayer(const PlayerOptions &options) {
+  if constexpr (std::is_constructible_v<Player, const PlayerOptions &>) {
+    return Player(options);
+  } else {
+    return Player{options.moves};
+  }
+}
+
+template <typename T, typename = void>
+struct HasReport : std::false_type {};
+
+template <typename T>
+struct HasReport<T, std::void_t<decltype(std::declval<const T &>().report(std::cout))>> : std::true_type {};
+
+// With cycles, a game of a stateless player that returns to an earlier state
+// skips every whole repeat of the cycle that fits in the pieces left.
+template <typename Player, typename Randomizer, typename B>
+void runGame(int seed, int pieces, const PlayerOptions &options, bool hold, int preview, int idle, bool cycles) {
+  using GameType = Game<Player, Randomizer, B>;
+  GameType game(seed, makePlayer<Player>(options), Randomizer(seed), hold, preview);
+
+  std::optional<CycleDetector<GameType>> detector;
+  if constexpr (GameType::stateless) {
+    if (cycles) detector.emplace();
+  } else {
+    if (cycles) std::cerr << "this AI has state of its own, so its games are played in full" << std::endl;
+  }
+
+  auto step = pieces/10;
+
+  for (int i = 0; i < pieces; i++) {
+    if (idle > 0) std::this_thread::sleep_for(std::chrono::microseconds(idle));
+    if (game.tick() == game.GameOver) break;
+    const auto &stats = game.stats();
+
+    if constexpr (GameType::stateless) {
+      if (detector && detector->step(game)) {
+        auto start = detector->cycleStart();
+        int length = detector->length;
+        int times = (pieces - stats.pieces) / length;
+
+        std::cout << "cycle=" << length << " pieces from piece " << start.pieces;
+        std::cout << ",lines_per_cycle=" << stats.linesCleared - start.linesCleared;
+        std::cout << ",skipped=" << times << " cycles" << std::endl;
+
+        game.fastForward(start, times);
+        i += times * length;
+        detector.reset();
+      }
+    }
+
+    if (stats.pieces > 0 && stats.pieces % step == 0) {
+      std::cout << "pieces=" << stats.pieces;
+      std::cout << ",lines_cleared=" << stats.linesCleared;
+
+      std::cout << ",piece_frequency=";
+      for (int p = 0; p < 7; p++) {
+        std::cout << stats.pieceFrequency.at((PieceType)p) << ",";
+      }
+
+      std::cout << std::endl;
+    }
+  }
+
+  game.print();
+
+  if constexpr (HasReport<Player>::value) {
+    std::cout << std::endl;
+    game.currentPlayer().report(std::cout);
+  }
+}
+
+// Plays a game of up to pieces pieces, for tournaments and sweeps.
+template <typename Player, typename Randomizer, typename B>
+GameStats playGame(int seed, int pieces, const PlayerOptions &options, bool hold, int preview) {
+  Game<Player, Randomizer, B> game(seed, makePlayer<Player>(options), Randomizer(seed), hold, preview);
+  for (int i = 0; i < pieces && game.tick() == game.Ok; i++);
+  return game.stats();
+}
+
+// Plays games games of up to pieces pieces each, seeded seed, seed+1, ...,
+// writing a TrainingRecord for every piece to path, then reads the file back
+// for a summary.
+template <typename Player, typename Randomizer, typename B>
+int runExport(int seed, int pieces, int games, const PlayerOptions &options, bool hold, int preview,
+              const std::string &path, int horizon, bool writerThread) {
+  TrainingWriter writer(path, B::height(), horizon, writerThread);
+  if (!writer.ok()) {
+    std::cerr << "could not write " << path << std::endl;
+    return 1;
+  }
+  TrainingRecorder recorder(writer, horizon);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int g = 0; g < games; g++) {
+    Game<Player, Randomizer, B> game(seed+g, makePlayer<Player>(options), Randomizer(seed+g), hold, preview);
+    game.record(&recorder);
+
+    bool over = false;
+    for (int i = 0; i < pieces && !over; i++) over = game.tick() == game.GameOver;
+    if (!over) recorder.endGame(false);
+  }
+
+  if (!writer.close()) {
+    std::cerr << "could not write " << path << std::endl;
+    return 1;
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  TrainingReader reader(path);
+  if (!reader.ok()) {
+    std::cerr << "could not read back " << path << std::endl;
+    return 1;
+  }
+
+  long died = 0, lines = 0;
+  for (const auto &record : reader) {
+    died += record.died;
+    lines += record.linesCleared;
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "games=" << games << ", records=" << reader.size() << ", lines=" << lines
+    << ", records_within_horizon_of_death=" << died << ", writer_stalls=" << writer.stalls
+    << ", seconds=" << elapsed.count() << std::endl;
+  return 0;
+}
 
 int main(int argc, char **argv) {
-  const std::map<std::string, PlayerFunc> ai = {
-    { "eltetris", elTetris },
-    { "yiyuan", yiyuan },
+  const std::map<std::string, AnyPlayer> ai = {
+    { "eltetris", TypeTag<ElTetris>() },
+    { "yiyuan", TypeTag<Yiyuan>() },
+    { "dellacherie", TypeTag<Dellacherie>() },
+    { "bcts", TypeTag<Bcts>() },
+    { "pc", TypeTag<PerfectClearPlayer<ElTetris>>() },
+    { "mc", TypeTag<MonteCarlo>() },
+    { "adaptive", TypeTag<AdaptiveDepth>() },
+    { "anytime", TypeTag<Anytime>() },
+    { "expectimax", TypeTag<ElTetrisExpectimax>() },
+    { "speculative", TypeTag<Speculative<ElTetrisExpectimax>>() },
+    { "book", TypeTag<OpeningBookPlayer<ElTetris>>() },
   };
 
-  const std::map<std::string, PieceRandomizer> randomizers = {
-    { "uniform", uniform},
-    { "nes", nes },
-    { "nesApprox", nesApprox },
-    { "7bag", sevenBag },
+  const std::map<std::string, AnyRandomizer> randomizers = {
+    { "uniform", TypeTag<UniformRandomizer>() },
+    { "nes", TypeTag<NesRandomizer>() },
+    { "nesApprox", TypeTag<NesApproxRandomizer>() },
+    { "7bag", TypeTag<SevenBagRandomizer>() },
+  };
+
+  // Keyed by height and whether the board keeps a transposed copy.
+  const std::map<std::pair<int, bool>, AnyBoard> boards = {
+    { { 20, false }, TypeTag<Board>() },
+    { { 24, false }, TypeTag<SpawnBoard>() },
+    { { 40, false }, TypeTag<TallBoard>() },
+    { { 20, true }, TypeTag<ColumnBoard>() },
+    { { 24, true }, TypeTag<SpawnColumnBoard>() },
+    { { 40, true }, TypeTag<TallColumnBoard>() },
   };
 
   argparse::ArgumentParser program("tetris");
 
+  program.add_argument("-m", "--mode")
+    .default_value(std::string{"play"})
+    .help("play, bench-rows to benchmark row feature kernels on -p boards, bench-lib to compare the C library's per-call overhead against direct calls on -p boards, mirror to check that AIs decide mirror images of -p boards alike, perft to count and time move generation, pc to search for perfect clears from an empty board with -p sequences of -n+1 pieces, engine to answer requests on stdin (see src/engine.h), loadgen to measure the engine's overhead on -p queries, analyze to write best moves for the positions in --input to --output (see src/analysis.h), export to write training data from --games games of up to -p pieces to --output (see src/trainingdata.h), tournament to compare the AI against --against on up to --games shared seeds of up to -p pieces, with a per-seed CSV to --output (see src/tournament.h), sweep to summarize --games games of up to -p pieces on -t threads, versus to play --games matches of up to -p pieces against --against with garbage lines (see src/versus.h), or book to write the AI's moves for the first --book-pieces pieces to --output (see src/book.h)");
+
   program.add_argument("-a", "--ai")
     .default_value(std::string{"eltetris"})
     .help("AI to use");
@@ -31,6 +242,105 @@ int main(int argc, char **argv) {
     .default_value(std::string{"7bag"})
     .help("randomizer to use");
 
+  program.add_argument("-H", "--height")
+    .default_value(20)
+    .help("board height (20, 24 or 40)")
+    .scan<'i', int>();
+
+  program.add_argument("-c", "--columns")
+    .default_value(false)
+    .implicit_value(true)
+    .help("keep a column-major copy of the board for column features");
+
+  program.add_argument("-M", "--moves")
+    .default_value(std::string{"harddrop"})
+    .help("moves the AI considers: harddrop, or reachable for soft drops, tucks and spins");
+
+  program.add_argument("-o", "--hold")
+    .default_value(false)
+    .implicit_value(true)
+    .help("give the game a hold slot, and let the AI play either the current or the held piece");
+
+  program.add_argument("-n", "--preview")
+    .default_value(0)
+    .help("number of upcoming pieces shown to the AI")
+    .scan<'i', int>();
+
+  program.add_argument("-t", "--threads")
+    .default_value(0)
+    .help("threads for parallel search, 0 for one per hardware thread")
+    .scan<'i', int>();
+
+  program.add_argument("-D", "--danger")
+    .default_value(std::string{"10,16"})
+    .help("danger levels (stack height plus holes) at which the adaptive AI searches one piece deeper");
+
+  program.add_argument("-b", "--budget")
+    .default_value(1000)
+    .help("time the anytime AI has for each move, in microseconds")
+    .scan<'i', int>();
+
+  program.add_argument("-i", "--idle")
+    .default_value(0)
+    .help("microseconds to wait before each piece arrives, as in an interactive game")
+    .scan<'i', int>();
+
+  program.add_argument("--cycles")
+    .default_value(false)
+    .implicit_value(true)
+    .help("detect when the game repeats itself and skip the repeats");
+
+  program.add_argument("-d", "--depth")
+    .default_value(3)
+    .help("perft depth, and pieces the expectimax AIs look at")
+    .scan<'i', int>();
+
+  program.add_argument("--input")
+    .default_value(std::string{})
+    .help("positions to analyze");
+
+  program.add_argument("--output")
+    .default_value(std::string{})
+    .help("file the analysis or training data is written to");
+
+  program.add_argument("--games")
+    .default_value(1)
+    .help("games to export or sweep, matches to play, or the most a tournament plays")
+    .scan<'i', int>();
+
+  program.add_argument("--horizon")
+    .default_value(1000)
+    .help("pieces ahead the exported outcome labels look")
+    .scan<'i', int>();
+
+  program.add_argument("--writer-thread")
+    .default_value(false)
+    .implicit_value(true)
+    .help("write exported training data from a background thread");
+
+  program.add_argument("--against")
+    .default_value(std::string{"yiyuan"})
+    .help("AI the selected one plays against in a tournament or versus match");
+
+  program.add_argument("--messiness")
+    .default_value(0.3)
+    .help("chance that each garbage row in a versus match has its hole in a new column")
+    .scan<'g', double>();
+
+  program.add_argument("--confidence")
+    .default_value(0.95)
+    .help("confidence at which a tournament stops")
+    .scan<'g', double>();
+
+  program.add_argument("--book")
+    .default_value(std::string{})
+    .help("opening book the book AI plays from");
+
+  program.add_argument("--book-pieces")
+    .default_value(7)
+    .help("pieces from the start of a game an opening book covers")
+    .scan<'i', int>();
+
   program.add_argument("-s", "--seed")
     .default_value(0)
     .help("RNG seed")
@@ -50,6 +360,15 @@ int main(int argc, char **argv) {
     std::exit(1);
   }
 
+  auto mode = program.get<std::string>("--mode");
+  if (mode != "play" && mode != "bench-rows" && mode != "bench-lib" && mode != "perft" &&
+      mode != "pc" && mode != "engine" && mode != "loadgen" && mode != "analyze" &&
+      mode != "export" && mode != "book" && mode != "mirror" && mode != "tournament" &&
+      mode != "sweep" && mode != "versus") {
+    std::cerr << "invalid mode: " << mode << std::endl;
+    std::exit(1);
+  }
+
   auto aiName = program.get<std::string>("--ai");
   if (ai.find(aiName) == ai.end()) {
     std::cerr << "invalid ai: " << aiName << std::endl;
@@ -62,38 +381,278 @@ int main(int argc, char **argv) {
     std::exit(1);
   }
 
-  auto player = ai.at(aiName);
-  auto randomizer = randomizers.at(randomizerName);
+  auto height = program.get<int>("--height");
+  auto columns = program.get<bool>("--columns");
+  if (boards.find({height, columns}) == boards.end()) {
+    std::cerr << "invalid height: " << height << std::endl;
+    std::exit(1);
+  }
+
+  const std::map<std::string, MoveSet> moveSets = {
+    { "harddrop", MoveSet::HardDrops },
+    { "reachable", MoveSet::Reachable },
+  };
+
+  auto movesName = program.get<std::string>("--moves");
+  if (moveSets.find(movesName) == moveSets.end()) {
+    std::cerr << "invalid moves: " << movesName << std::endl;
+    std::exit(1);
+  }
+
+  auto hold = program.get<bool>("--hold");
+
+  auto preview = program.get<int>("--preview");
+  if (preview < 0 || preview > PiecePreview::capacity) {
+    std::cerr << "invalid preview: " << preview << std::endl;
+    std::exit(1);
+  }
+
+  auto threads = program.get<int>("--threads");
+  PlayerOptions playerOptions;
+  playerOptions.moves = moveSets.at(movesName);
+  playerOptions.threads = threads;
+  playerOptions.budget = program.get<int>("--budget");
+  playerOptions.depth = program.get<int>("--depth");
+  playerOptions.book = program.get<std::string>("--book");
+  playerOptions.randomizer = randomizerName;
+  playerOptions.danger.clear();
+
+  std::stringstream danger(program.get<std::string>("--danger"));
+  for (std::string level; std::getline(danger, level, ','); ) {
+    try {
+      playerOptions.danger.push_back(std::stoi(level));
+    } catch (const std::exception &) {
+      std::cerr << "invalid danger level: " << level << std::endl;
+      std::exit(1);
+    }
+  }
+
   auto seed = program.get<int>("--seed");
   auto pieces = program.get<int>("--pieces");
 
-  std::cout << "ai=" << aiName << std::endl;
-  std::cout << "randomizer=" << randomizerName << std::endl;
-  std::cout << "seed=" << seed << std::endl;
-  std::cout << "pieces=" << pieces << std::endl;
-  std::cout << std::endl;
+  if (mode == "bench-rows") return benchRowKernels(seed, pieces);
+  if (mode == "bench-lib") return benchLibrary(seed, pieces);
+  if (mode == "mirror") return checkMirror(seed, pieces);
+  if (mode == "perft") return benchMoveGen(seed, pieces, program.get<int>("--depth"));
+  if (mode == "pc") return benchPerfectClear(seed, pieces, preview+1, moveSets.at(movesName), threads);
 
-  Game game (seed, randomizer);
+  if (mode == "analyze") {
+    return runAnalysis(program.get<std::string>("--input"), program.get<std::string>("--output"),
+                       aiName, moveSets.at(movesName), threads);
+  }
 
-  auto step = pieces/10;
+  if (mode == "export") {
+    if (program.get<std::string>("--output").empty()) {
+      std::cerr << "export needs an --output file" << std::endl;
+      return 1;
+    }
+    if (program.get<int>("--horizon") < 1) {
+      std::cerr << "horizon must be positive" << std::endl;
+      return 1;
+    }
 
-  for (int i = 0; i < pieces; i++) {
-    if (game.tick(player) == Game::GameOver) break;
-    const auto &stats = game.stats();
-    if (stats.pieces > 0 && stats.pieces % step == 0) {
-      std::cout << "pieces=" << stats.pieces;
-      std::cout << ",lines_cleared=" << stats.linesCleared;
+    int result = 0;
+    std::visit(
+        [&](auto player, auto randomizer, auto board) {
+          result = runExport<
+            typename decltype(player)::type,
+            typename decltype(randomizer)::type,
+            typename decltype(board)::type>(
+              seed, pieces, program.get<int>("--games"), playerOptions, hold, preview,
+              program.get<std::string>("--output"), program.get<int>("--horizon"),
+              program.get<bool>("--writer-thread"));
+        },
+        ai.at(aiName), randomizers.at(randomizerName), boards.at({height, columns}));
+    return result;
+  }
 
-      std::cout << ",piece_frequency=";
-      for (int p = 0; p < 7; p++) {
-        std::cout << stats.pieceFrequency.at((PieceType)p) << ",";
-      }
+  // Games in tournaments and sweeps run in parallel, so each AI searches on
+  // one thread.
+  auto contender = [&](const std::string &name) {
+    auto options = playerOptions;
+    options.threads = 1;
 
-      std::cout << std::endl;
+    TournamentPlayer play;
+    std::visit(
+        [&](auto player, auto randomizer, auto board) {
+          play = [=](int seed) {
+            return playGame<
+              typename decltype(player)::type,
+              typename decltype(randomizer)::type,
+              typename decltype(board)::type>(seed, pieces, options, hold, preview);
+          };
+        },
+        ai.at(name), randomizers.at(randomizerName), boards.at({height, columns}));
+    return play;
+  };
+
+  if (mode == "sweep") {
+    auto start = std::chrono::steady_clock::now();
+    auto summary = runSweep(contender(aiName), seed, program.get<int>("--games"), threads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "games=" << summary.lines.stats.count() << ", seconds=" << elapsed.count() << std::endl;
+    reportSummary(summary);
+    return 0;
+  }
+
+  if (mode == "tournament") {
+    auto against = program.get<std::string>("--against");
+    if (ai.find(against) == ai.end()) {
+      std::cerr << "invalid ai: " << against << std::endl;
+      return 1;
     }
+
+    auto games = program.get<int>("--games");
+    auto confidence = program.get<double>("--confidence");
+    if (games < 2 || confidence <= 0 || confidence >= 1) {
+      std::cerr << "a tournament needs at least 2 games and a confidence between 0 and 1" << std::endl;
+      return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = runTournament(contender(aiName), contender(against), seed, games, confidence, threads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    auto csv = program.get<std::string>("--output");
+    if (!reportTournament(result, aiName, against, confidence, csv)) {
+      std::cerr << "could not write " << csv << std::endl;
+      return 1;
+    }
+    std::cout << "seconds=" << elapsed.count() << std::endl;
+    return 0;
   }
 
-  game.print();
+  if (mode == "versus") {
+    auto against = program.get<std::string>("--against");
+    if (ai.find(against) == ai.end()) {
+      std::cerr << "invalid ai: " << against << std::endl;
+      return 1;
+    }
+    if (height != Board::height() || columns) {
+      std::cerr << "versus matches are played on the standard board" << std::endl;
+      return 1;
+    }
+
+    VersusOptions versus;
+    versus.pieces = pieces;
+    versus.messiness = program.get<double>("--messiness");
+
+    auto options = playerOptions;
+    options.threads = 1;
+
+    auto games = program.get<int>("--games");
+    auto start = std::chrono::steady_clock::now();
+    VersusSummary summary;
+    std::visit(
+        [&](auto a, auto b, auto randomizer) {
+          summary = runMatches<typename decltype(randomizer)::type>(
+              [&] { return makePlayer<typename decltype(a)::type>(options); },
+              [&] { return makePlayer<typename decltype(b)::type>(options); },
+              seed, games, versus, threads);
+        },
+        ai.at(aiName), ai.at(against), randomizers.at(randomizerName));
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "matches=" << games << ", seconds=" << elapsed.count()
+      << ", matches_per_minute=" << games / elapsed.count() * 60 << std::endl;
+    std::cout << aiName << ": wins=" << summary.wins[0] << ", sent=" << summary.sent[0].mean() << std::endl;
+    std::cout << against << ": wins=" << summary.wins[1] << ", sent=" << summary.sent[1].mean() << std::endl;
+    std::cout << "draws=" << summary.draws << ", pieces=" << summary.pieces.mean()
+      << ", max_pieces=" << summary.pieces.max() << std::endl;
+    return 0;
+  }
+
+  if (mode == "book") {
+    auto path = program.get<std::string>("--output");
+    auto bookPieces = program.get<int>("--book-pieces");
+    std::unordered_map<uint64_t, DropMove> moves;
+    BookBuild build;
+    int width = 0;
+
+    // Reachable placements are not mirror-symmetric.
+    bool mirrored = playerOptions.moves == MoveSet::HardDrops;
+
+    auto start = std::chrono::steady_clock::now();
+    std::visit(
+        [&](auto player, auto board) {
+          using Player = typename decltype(player)::type;
+          using B = typename decltype(board)::type;
+          width = B::width();
+          build = buildBook<B>(bookPieces, randomizerName == "7bag", mirrored, threads,
+                               [&] { return makePlayer<Player>(playerOptions); }, moves);
+        },
+        ai.at(aiName), boards.at({height, columns}));
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (!writeBook(path, width, height, bookPieces, mirrored, moves)) {
+      std::cerr << "could not write " << path << std::endl;
+      return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "pieces=" << bookPieces << ", positions=" << build.positions
+      << ", decisions=" << build.decisions << ", entries=" << moves.size()
+      << ", seconds=" << elapsed.count() << std::endl;
+    return 0;
+  }
+
+  if (mode == "engine") {
+    EngineIO io;
+    for (auto current = aiName; !current.empty(); ) {
+      std::string next;
+      std::visit(
+          [&](auto player, auto board) {
+            auto p = makePlayer<typename decltype(player)::type>(playerOptions);
+            next = runEngine<typename decltype(board)::type>(io, p);
+          },
+          ai.at(current), boards.at({height, columns}));
+
+      if (!next.empty()) {
+        if (ai.find(next) == ai.end()) {
+          io.write("error unknown ai\n");
+        } else {
+          io.write("ok\n");
+          current = next;
+        }
+      } else {
+        current = next;
+      }
+    }
+    return 0;
+  }
+
+  if (mode == "loadgen") {
+    PlayerFunc direct;
+    std::visit(
+        [&](auto player) {
+          using Player = typename decltype(player)::type;
+          auto p = std::make_shared<Player>(makePlayer<Player>(playerOptions));
+          direct = [p](const Board &board, PieceType piece) { return (*p)(board, piece); };
+        },
+        ai.at(aiName));
+    return runLoadGenerator(argv[0], aiName, movesName, seed, pieces, direct);
+  }
+
+  std::cout << "ai=" << aiName << std::endl;
+  std::cout << "randomizer=" << randomizerName << std::endl;
+  std::cout << "seed=" << seed << std::endl;
+  std::cout << "height=" << height << std::endl;
+  if (moveSets.at(movesName) != MoveSet::HardDrops) std::cout << "moves=" << movesName << std::endl;
+  if (hold) std::cout << "hold=true" << std::endl;
+  if (preview > 0) std::cout << "preview=" << preview << std::endl;
+  std::cout << "pieces=" << pieces << std::endl;
+  std::cout << std::endl;
+
+  std::visit(
+      [&](auto player, auto randomizer, auto board) {
+        runGame<
+          typename decltype(player)::type,
+          typename decltype(randomizer)::type,
+          typename decltype(board)::type>(seed, pieces, playerOptions, hold, preview, program.get<int>("--idle"),
+                                          program.get<bool>("--cycles"));
+      },
+      ai.at(aiName), randomizers.at(randomizerName), boards.at({height, columns}));
 
   return 0;
 }
@@ -0,0 +1,131 @@
+#ifndef _MIRROR_H_
+#define _MIRROR_H_
+
+#include "tetris.h"
+
+#include <array>
+#include <cstdint>
+
+// Left-right mirror images. The piece set is mirror-symmetric: S and Z swap,
+// L and J swap, and I, O and T are their own mirror images, so the mirror
+// image of a placement is a placement of the mirrored piece, with the rotation
+// whose shape is the mirrored shape. On a mirrored board, hard drops mirror to
+// hard drops, and every feature in boardfeatures.h takes the same value, so
+// the evaluators score mirrored afterstates alike. (SRS kicks are not
+// symmetric, so reachable placements can differ.)
+//
+// A (board, piece) pair and its mirror image share one canonical form, the
+// one whose rows, read from the bottom up and then followed by the piece,
+// compare lower. Caches keyed on the canonical form hold one entry for both.
+
+inline constexpr PieceType mirrorPiece(PieceType piece) {
+  switch (piece) {
+    case L: return J;
+    case J: return L;
+    case S: return Z;
+    case Z: return S;
+    default: return piece;
+  }
+}
+
+template <int W>
+constexpr BoardRow<W> mirrorRow(BoardRow<W> r) {
+  BoardRow<W> mirrored = 0;
+  for (int j = 0; j < W; j++) mirrored |= BoardRow<W>((r >> j) & 1) << (W-1-j);
+  return mirrored;
+}
+
+// Rotation of mirrorPiece(piece) with the mirrored shape of rotation rot.
+inline constexpr std::array<std::array<int, 4>, 7> mirrorRotations = [] {
+  std::array<std::array<int, 4>, 7> table {};
+
+  for (int p = 0; p < 7; p++) {
+    auto mirrored = mirrorPiece(PieceType(p));
+    for (int rot = 0; rot < pieceRotations(PieceType(p)); rot++) {
+      const auto &shape = pieceShape(PieceType(p), rot);
+      table[p][rot] = -1;
+
+      for (int m = 0; m < pieceRotations(mirrored); m++) {
+        const auto &other = pieceShape(mirrored, m);
+        if (other.width != shape.width || other.height != shape.height) continue;
+
+        bool same = true;
+        for (int i = 0; i < shape.height; i++) {
+          uint16_t row = 0;
+          for (int j = 0; j < shape.width; j++) row |= ((shape.rows[i] >> j) & 1) << (shape.width-1-j);
+          same = same && row == other.rows[i];
+        }
+        if (same) table[p][rot] = m;
+      }
+    }
+  }
+
+  return table;
+}();
+
+static_assert([] {
+  for (int p = 0; p < 7; p++) {
+    for (int rot = 0; rot < pieceRotations(PieceType(p)); rot++) {
+      if (mirrorRotations[p][rot] < 0) return false;
+    }
+  }
+  return true;
+}(), "every rotation has a mirror image");
+
+template <typename B>
+B mirrorBoard(const B &board) {
+  std::array<typename B::Row, B::height()> rows;
+  for (int i = 0; i < B::height(); i++) rows[i] = mirrorRow<B::width()>(board.row(i));
+  return B(rows);
+}
+
+// The mirror image of move, a placement of piece on a W-wide board, as a
+// placement of mirrorPiece(piece).
+template <int W>
+DropMove mirrorMove(PieceType piece, DropMove move) {
+  if (!move.valid()) return move;
+
+  DropMove mirrored = move;
+  mirrored.col = W - move.col - pieceShape(piece, move.rot).width;
+  mirrored.rot = mirrorRotations[piece][move.rot];
+  return mirrored;
+}
+
+// 7-bag state as a mask of the pieces already dealt from the current bag.
+inline constexpr uint8_t mirrorBag(uint8_t bag) {
+  uint8_t mirrored = 0;
+  for (int p = 0; p < 7; p++) {
+    if ((bag >> p) & 1) mirrored |= 1 << mirrorPiece(PieceType(p));
+  }
+  return mirrored;
+}
+
+// Whether the mirror image of board and piece is their canonical form.
+template <typename B>
+bool mirrorIsCanonical(const B &board, PieceType piece) {
+  for (int i = B::height()-1; i >= B::height()-board.stackHeight(); i--) {
+    auto r = board.row(i), m = mirrorRow<B::width()>(r);
+    if (r != m) return m < r;
+  }
+  return mirrorPiece(piece) < piece;
+}
+
+template <typename B>
+struct Canonical {
+  B board;
+  PieceType piece;
+  bool mirrored;
+
+  // Maps a move on the canonical form back to the original board.
+  DropMove original(DropMove move) const {
+    return mirrored ? mirrorMove<B::width()>(piece, move) : move;
+  }
+};
+
+template <typename B>
+Canonical<B> canonical(const B &board, PieceType piece) {
+  if (mirrorIsCanonical(board, piece)) return { mirrorBoard(board), mirrorPiece(piece), true };
+  return { board, piece, false };
+}
+
+#endif
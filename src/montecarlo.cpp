@@ -0,0 +1,95 @@
+#include "montecarlo.h"
+#include "eltetris.h"
+#include "parallel.h"
+#include "randomizers.h"
+
+#include <algorithm>
+#include <vector>
+
+template <typename B, typename Randomizer>
+static double rollout(B board, Move last, int depth, Randomizer rng, const MonteCarloOptions &options) {
+  int lines = 0;
+
+  for (int d = 0; d < depth; d++) {
+    auto piece = rng();
+    auto move = greedyMove(elTetrisEvaluator, board, piece);
+    if (!move.valid()) return lines - options.deathPenalty;
+
+    last = board.playMove(piece, move);
+    if (!last.valid()) return lines - options.deathPenalty;
+    lines += last.linesCleared;
+  }
+
+  return lines + options.leafWeight * elTetrisEvaluator.score(board, last);
+}
+
+template <typename B>
+DropMove monteCarlo(const B &board, PieceType piece, const MonteCarloOptions &options,
+                    uint64_t decision, MoveSet moves, uint8_t dealt) {
+  struct Candidate {
+    DropMove move;
+    double score;
+  };
+
+  std::vector<Candidate> candidates;
+  IncrementalEvaluator<decltype(elTetrisEvaluator), B> evaluator(elTetrisEvaluator, board);
+
+  enumerateMoves(board, piece, moves,
+      [&](DropMove move) {
+        auto eval = evaluator.evaluate(piece, move);
+        if (eval.valid) candidates.push_back({ move, eval.score });
+      });
+
+  if (candidates.empty()) return DropMove::invalid();
+
+  std::stable_sort(candidates.begin(), candidates.end(),
+      [](const Candidate &a, const Candidate &b) { return a.score > b.score; });
+  if ((int)candidates.size() > options.candidates) candidates.erase(candidates.begin()+options.candidates, candidates.end());
+
+  std::vector<B> boards(candidates.size(), board);
+  std::vector<Move> played;
+  for (size_t k = 0; k < candidates.size(); k++) played.push_back(boards[k].playMove(piece, candidates[k].move));
+
+  int rollouts = options.rollouts;
+  std::vector<double> values(candidates.size()*rollouts);
+  StreamRandomizer streams(options.seed ^ (decision * 0xd1b54a32d192ed03ull));
+  std::vector<uint64_t> seeds(rollouts);
+  for (auto &seed : seeds) seed = streams.next();
+
+  parallelFor((int)values.size(), options.threads,
+      [&](int i, int) {
+        const auto &start = boards[i/rollouts];
+        auto last = played[i/rollouts];
+        auto seed = seeds[i%rollouts];
+
+        switch (options.pieces) {
+          case RolloutPieces::SevenBag:
+            values[i] = rollout(start, last, options.depth, SevenBagRandomizer(int(seed), dealt), options);
+            break;
+          case RolloutPieces::Nes:
+            values[i] = rollout(start, last, options.depth, NesApproxRandomizer(int(seed), piece), options);
+            break;
+          default:
+            values[i] = rollout(start, last, options.depth, StreamRandomizer(seed), options);
+        }
+      });
+
+  double bestValue = 0;
+  int best = -1;
+  for (int k = 0; k < (int)candidates.size(); k++) {
+    double value = 0;
+    for (int r = 0; r < rollouts; r++) value += values[k*rollouts + r];
+    value /= rollouts;
+
+    if (best < 0 || value > bestValue) {
+      bestValue = value;
+      best = k;
+    }
+  }
+
+  return candidates[best].move;
+}
+
+#define INSTANTIATE(B) \
+  template DropMove monteCarlo(const B &board, PieceType piece, const MonteCarloOptions &options, uint64_t decision, MoveSet moves, uint8_t dealt);
+FOR_EACH_BOARD(INSTANTIATE)
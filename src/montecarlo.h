@@ -0,0 +1,72 @@
+#ifndef _MONTECARLO_H_
+#define _MONTECARLO_H_
+
+#include "tetris.h"
+#include "movegen.h"
+#include "ai.h"
+
+#include <cstdint>
+
+// Scores the best few placements by El-Tetris with rollouts: each rollout
+// plays depth more pieces, drawn like the game's, with greedy El-Tetris on hard
+// drops, and is worth the lines it clears plus leafWeight times the El-Tetris
+// score of the board it ends on, or minus deathPenalty if it tops out.
+// Counting lines alone over so short a horizon favours burying holes for a
+// quick clear. The placement with the best mean wins, ties going to the
+// better El-Tetris score.
+//
+// Rollouts run in parallel. Rollout r of every candidate draws its pieces
+// from the same stream, derived from seed, the decision number and r, so
+// candidates are compared on the same sequences, and the result does not
+// depend on how rollouts are spread over threads.
+//
+// The player only sees the pieces it is given, so rollout pieces follow the
+// game's randomizer as far as those tell: with SevenBag they finish the bag
+// of the pieces seen so far (tracked from the start of the game, which
+// assumes the player is asked about every piece in order, without hold or
+// preview; a piece seen twice starts a new bag), and with Nes they follow the
+// first-order approximation of the NES randomizer from the current piece.
+enum class RolloutPieces { Uniform, SevenBag, Nes };
+
+struct MonteCarloOptions {
+  int candidates = 4;
+  int rollouts = 16;
+  int depth = 10;
+  double deathPenalty = 100.0;
+  double leafWeight = 1.0;
+  uint64_t seed = 0;
+  RolloutPieces pieces = RolloutPieces::Uniform;
+
+  // 0 for as many as there are hardware threads.
+  int threads = 0;
+};
+
+// dealt is the mask of the pieces dealt from the current bag, including
+// piece, for RolloutPieces::SevenBag.
+template <typename B>
+DropMove monteCarlo(const B &board, PieceType piece, const MonteCarloOptions &options,
+                    uint64_t decision, MoveSet moves = MoveSet::HardDrops, uint8_t dealt = 0);
+
+class MonteCarlo {
+private:
+  MoveSet moves;
+  MonteCarloOptions options;
+  uint64_t decisions = 0;
+  uint8_t dealt = 0;
+
+public:
+  explicit MonteCarlo(const PlayerOptions &player = {}): moves(player.moves) {
+    options.threads = player.threads;
+    if (player.randomizer == "7bag") options.pieces = RolloutPieces::SevenBag;
+    if (player.randomizer == "nes" || player.randomizer == "nesApprox") options.pieces = RolloutPieces::Nes;
+  }
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) {
+    if ((dealt >> piece) & 1 || dealt == 0x7f) dealt = 0;
+    dealt |= 1 << piece;
+    return monteCarlo(board, piece, options, decisions++, moves, dealt);
+  }
+};
+
+#endif
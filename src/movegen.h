@@ -0,0 +1,317 @@
+#ifndef _MOVEGEN_H_
+#define _MOVEGEN_H_
+
+#include "tetris.h"
+
+// Every placement reachable from the top of the board by shifting, soft
+// dropping and rotating, including slides under overhangs and spins, using
+// the SRS rotation system and kick tables.
+//
+// Like enumerateMoves, a piece may start in any rotation and column in which
+// it fits at row 0. From there the search is a flood fill over (state, row,
+// column), where each (state, row) keeps a bitmask of columns, so a shift or
+// a drop moves a whole row of positions at once.
+
+enum class MoveSet {
+  // One move per rotation and column, dropped straight down.
+  HardDrops,
+
+  // Every placement reachable with shifts, soft drops and rotations.
+  Reachable,
+};
+
+// An SRS state in board terms: which of pieceShapes' rotations it uses, and
+// where the top-left corner of that shape sits inside the SRS bounding box.
+struct SrsState {
+  int rot, row, col;
+};
+
+// Where the top-left corner of the shape moves to for one kick, in board
+// rows and columns.
+struct SrsKick {
+  int row, col;
+};
+
+struct SrsPiece {
+  std::array<SrsState, 4> states;
+  int count;
+
+  // Indexed by state, then 0 for clockwise and 1 for counter-clockwise.
+  std::array<std::array<std::array<SrsKick, 5>, 2>, 4> kicks;
+  int kickCount;
+};
+
+namespace srs {
+
+// Cells of each guideline piece's states in the SRS bounding box as (row,
+// column), row 0 at the top, in the order spawn, R, 2, L.
+using Cells = std::array<std::array<int, 2>, 4>;
+
+inline constexpr std::array<std::array<Cells, 4>, 7> cells = {{
+  // I
+  {{ {{ {1, 0}, {1, 1}, {1, 2}, {1, 3} }},
+     {{ {0, 2}, {1, 2}, {2, 2}, {3, 2} }},
+     {{ {2, 0}, {2, 1}, {2, 2}, {2, 3} }},
+     {{ {0, 1}, {1, 1}, {2, 1}, {3, 1} }} }},
+
+  // O
+  {{ {{ {0, 1}, {0, 2}, {1, 1}, {1, 2} }} }},
+
+  // T
+  {{ {{ {0, 1}, {1, 0}, {1, 1}, {1, 2} }},
+     {{ {0, 1}, {1, 1}, {1, 2}, {2, 1} }},
+     {{ {1, 0}, {1, 1}, {1, 2}, {2, 1} }},
+     {{ {0, 1}, {1, 0}, {1, 1}, {2, 1} }} }},
+
+  // L
+  {{ {{ {0, 2}, {1, 0}, {1, 1}, {1, 2} }},
+     {{ {0, 1}, {1, 1}, {2, 1}, {2, 2} }},
+     {{ {1, 0}, {1, 1}, {1, 2}, {2, 0} }},
+     {{ {0, 0}, {0, 1}, {1, 1}, {2, 1} }} }},
+
+  // J
+  {{ {{ {0, 0}, {1, 0}, {1, 1}, {1, 2} }},
+     {{ {0, 1}, {0, 2}, {1, 1}, {2, 1} }},
+     {{ {1, 0}, {1, 1}, {1, 2}, {2, 2} }},
+     {{ {0, 1}, {1, 1}, {2, 0}, {2, 1} }} }},
+
+  // S
+  {{ {{ {0, 1}, {0, 2}, {1, 0}, {1, 1} }},
+     {{ {0, 1}, {1, 1}, {1, 2}, {2, 2} }},
+     {{ {1, 1}, {1, 2}, {2, 0}, {2, 1} }},
+     {{ {0, 0}, {1, 0}, {1, 1}, {2, 1} }} }},
+
+  // Z
+  {{ {{ {0, 0}, {0, 1}, {1, 1}, {1, 2} }},
+     {{ {0, 2}, {1, 1}, {1, 2}, {2, 1} }},
+     {{ {1, 0}, {1, 1}, {2, 1}, {2, 2} }},
+     {{ {0, 1}, {1, 0}, {1, 1}, {2, 0} }} }},
+}};
+
+// Kick offsets as (x, y) with y pointing up, as the SRS guideline lists them,
+// indexed by state, then clockwise and counter-clockwise.
+using Kicks = std::array<std::array<std::array<std::array<int, 2>, 5>, 2>, 4>;
+
+inline constexpr Kicks jlstzKicks = {{
+  {{ {{ {0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2} }},     // 0->R
+     {{ {0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2} }} }},     // 0->L
+  {{ {{ {0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2} }},         // R->2
+     {{ {0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2} }} }},      // R->0
+  {{ {{ {0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2} }},        // 2->L
+     {{ {0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2} }} }},  // 2->R
+  {{ {{ {0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2} }},      // L->0
+     {{ {0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2} }} }},   // L->2
+}};
+
+inline constexpr Kicks iKicks = {{
+  {{ {{ {0, 0}, {-2, 0}, {1, 0}, {-2, -1}, {1, 2} }},       // 0->R
+     {{ {0, 0}, {-1, 0}, {2, 0}, {-1, 2}, {2, -1} }} }},    // 0->L
+  {{ {{ {0, 0}, {-1, 0}, {2, 0}, {-1, 2}, {2, -1} }},       // R->2
+     {{ {0, 0}, {2, 0}, {-1, 0}, {2, 1}, {-1, -2} }} }},    // R->0
+  {{ {{ {0, 0}, {2, 0}, {-1, 0}, {2, 1}, {-1, -2} }},       // 2->L
+     {{ {0, 0}, {1, 0}, {-2, 0}, {1, -2}, {-2, 1} }} }},    // 2->R
+  {{ {{ {0, 0}, {1, 0}, {-2, 0}, {1, -2}, {-2, 1} }},       // L->0
+     {{ {0, 0}, {-2, 0}, {1, 0}, {-2, -1}, {1, 2} }} }},    // L->2
+}};
+
+// Finds the rotation in pieceShapes matching a state's trimmed cells, and
+// where that shape sits in the bounding box. rot is -1 if none matches.
+constexpr SrsState makeState(PieceType piece, const Cells &cells) {
+  int top = 4, left = 4, bottom = 0, right = 0;
+  for (const auto &c : cells) {
+    top = c[0] < top ? c[0] : top;
+    left = c[1] < left ? c[1] : left;
+    bottom = c[0] > bottom ? c[0] : bottom;
+    right = c[1] > right ? c[1] : right;
+  }
+
+  std::array<uint16_t, 4> rows {};
+  for (const auto &c : cells) rows[c[0]-top] |= 1 << (c[1]-left);
+
+  for (int rot = 0; rot < pieceRotations(piece); rot++) {
+    const auto &shape = pieceShape(piece, rot);
+    if (shape.width != right-left+1 || shape.height != bottom-top+1) continue;
+
+    bool same = true;
+    for (int i = 0; i < shape.height; i++) same = same && shape.rows[i] == rows[i];
+    if (same) return { rot, top, left };
+  }
+
+  return { -1, top, left };
+}
+
+constexpr std::array<SrsPiece, 7> makePieces() {
+  std::array<SrsPiece, 7> pieces {};
+
+  for (int p = 0; p < 7; p++) {
+    auto &piece = pieces[p];
+    piece.count = p == O ? 1 : 4;
+    piece.kickCount = p == O ? 1 : 5;
+
+    // pieceShapes draws L, J, S and Z mirrored from the guideline pieces of
+    // the same name, so match on shape rather than on name.
+    for (int q = 0; q < 7; q++) {
+      bool matches = true;
+      for (int s = 0; s < piece.count; s++) {
+        piece.states[s] = makeState(PieceType(p), cells[q][s]);
+        matches = matches && piece.states[s].rot >= 0;
+      }
+      if (matches) break;
+    }
+
+    if (p == O) continue;
+
+    const auto &kicks = p == I ? iKicks : jlstzKicks;
+    for (int s = 0; s < 4; s++) {
+      for (int dir = 0; dir < 2; dir++) {
+        const auto &from = piece.states[s];
+        const auto &to = piece.states[(s + (dir == 0 ? 1 : 3)) % 4];
+
+        for (int k = 0; k < 5; k++) {
+          piece.kicks[s][dir][k] = {
+            -from.row + to.row - kicks[s][dir][k][1],
+            -from.col + to.col + kicks[s][dir][k][0],
+          };
+        }
+      }
+    }
+  }
+
+  return pieces;
+}
+
+constexpr bool piecesValid(const std::array<SrsPiece, 7> &pieces) {
+  for (const auto &piece : pieces) {
+    for (int s = 0; s < piece.count; s++) {
+      if (piece.states[s].rot < 0) return false;
+    }
+  }
+  return true;
+}
+
+}
+
+inline constexpr std::array<SrsPiece, 7> srsPieces = srs::makePieces();
+static_assert(srs::piecesValid(srsPieces), "every SRS state must match a rotation in pieceShapes");
+
+// Calls fn(DropMove) once per distinct resting placement, with row set.
+template <typename B, typename Fn>
+void enumerateReachableMoves(const B &board, PieceType piece, Fn &&fn) {
+  using Row = typename B::Row;
+  constexpr int H = B::height();
+
+  const auto &srs = srsPieces[piece];
+  const int rots = pieceRotations(piece);
+
+  // fits[rot][i]: columns where the shape fits with its top at row i.
+  std::array<std::array<Row, H>, 4> fits;
+  for (int rot = 0; rot < rots; rot++) {
+    const auto &shape = pieceShape(piece, rot);
+    Row columns = Row(~Row(0)) >> (8*sizeof(Row) - (B::width()-shape.width+1));
+
+    for (int i = 0; i < H; i++) {
+      if (i+shape.height > H) {
+        fits[rot][i] = 0;
+        continue;
+      }
+
+      Row blocked = 0;
+      for (int k = 0; k < shape.height; k++) {
+        for (uint16_t bits = shape.rows[k]; bits != 0; bits &= bits-1) {
+          blocked |= board.row(i+k) >> lowestBit(bits);
+        }
+      }
+      fits[rot][i] = columns & ~blocked;
+    }
+  }
+
+  // reach[s][i]: columns reached in SRS state s with the top at row i.
+  std::array<std::array<Row, H>, 4> reach {};
+  for (int s = 0; s < srs.count; s++) {
+    reach[s][0] = fits[srs.states[s].rot][0];
+  }
+
+  for (bool changed = true; changed; ) {
+    changed = false;
+
+    // Shifts and soft drops, top down so a drop carries on into the rows
+    // below within the same sweep.
+    for (int s = 0; s < srs.count; s++) {
+      const auto &f = fits[srs.states[s].rot];
+      auto &r = reach[s];
+
+      for (int i = 0; i < H; i++) {
+        Row m = r[i];
+        if (i > 0) m |= r[i-1] & f[i];
+        if (m == 0) continue;
+
+        for (Row spread = m; ; m = spread) {
+          spread = (m | Row(m << 1) | (m >> 1)) & f[i];
+          if (spread == m) break;
+        }
+
+        if (m != r[i]) {
+          r[i] = m;
+          changed = true;
+        }
+      }
+    }
+
+    // Rotations. Each position takes the first kick that fits.
+    for (int s = 0; s < srs.count && srs.count > 1; s++) {
+      for (int dir = 0; dir < 2; dir++) {
+        int to = (s + (dir == 0 ? 1 : 3)) % 4;
+        const auto &f = fits[srs.states[to].rot];
+
+        for (int i = 0; i < H; i++) {
+          Row pending = reach[s][i];
+
+          for (int k = 0; k < srs.kickCount && pending != 0; k++) {
+            const auto &kick = srs.kicks[s][dir][k];
+            int row = i + kick.row;
+            if (row < 0 || row >= H) continue;
+
+            Row moved = kick.col >= 0 ? Row(pending << kick.col) : Row(pending >> -kick.col);
+            moved &= f[row];
+            if (moved == 0) continue;
+
+            pending &= ~(kick.col >= 0 ? Row(moved >> kick.col) : Row(moved << -kick.col));
+
+            if ((reach[to][row] | moved) != reach[to][row]) {
+              reach[to][row] |= moved;
+              changed = true;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // States sharing a rotation reach the same placements, so merge them
+  // before emitting.
+  for (int rot = 0; rot < rots; rot++) {
+    for (int i = 0; i < H; i++) {
+      Row placed = 0;
+      for (int s = 0; s < srs.count; s++) {
+        if (srs.states[s].rot == rot) placed |= reach[s][i];
+      }
+
+      if (i+1 < H) placed &= ~fits[rot][i+1];
+
+      for (; placed != 0; placed &= placed-1) {
+        fn(DropMove(lowestBit(placed), rot, i));
+      }
+    }
+  }
+}
+
+template <typename B, typename Fn>
+void enumerateMoves(const B &board, PieceType piece, MoveSet moves, Fn &&fn) {
+  if (moves == MoveSet::Reachable) {
+    enumerateReachableMoves(board, piece, fn);
+  } else {
+    enumerateMoves(board, piece, fn);
+  }
+}
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of threads to use when the caller asks for 0 (as many as there are
+// hardware threads).
+inline int defaultThreads(int threads) {
+  if (threads > 0) return threads;
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls fn(i, thread) for every i in [0, count), handing indices out in
+// order to up to threads threads. thread is in [0, threads), so callers can
+// keep per-thread state in a plain vector. Runs inline with one thread.
+template <typename Fn>
+void parallelFor(int count, int threads, Fn &&fn) {
+  threads = std::min(defaultThreads(threads), count);
+  if (threads <= 1) {
+    for (int i = 0; i < count; i++) fn(i, 0);
+    return;
+  }
+
+  std::atomic<int> next(0);
+  auto work = [&](int thread) {
+    for (int i = next++; i < count; i = next++) fn(i, thread);
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads-1);
+  for (int t = 1; t < threads; t++) workers.emplace_back(work, t);
+  work(0);
+
+  for (auto &worker : workers) worker.join();
+}
+
+// Long-lived workers for tasks submitted one at a time, for callers that
+// hand out work often enough that starting threads each time would show.
+class ThreadPool {
+private:
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable wake, idle;
+  int running = 0;
+  bool stopping = false;
+
+  void work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      wake.wait(lock, [&] { return stopping || !tasks.empty(); });
+      if (tasks.empty()) return;
+
+      auto task = std::move(tasks.front());
+      tasks.pop_front();
+      running++;
+
+      lock.unlock();
+      task();
+      lock.lock();
+
+      running--;
+      if (running == 0 && tasks.empty()) idle.notify_all();
+    }
+  }
+
+public:
+  explicit ThreadPool(int threads) {
+    threads = defaultThreads(threads);
+    for (int t = 0; t < threads; t++) workers.emplace_back([this] { work(); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers) worker.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int size() const { return workers.size(); }
+
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+  }
+
+  // Blocks until every submitted task has finished.
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [&] { return running == 0 && tasks.empty(); });
+  }
+};
+
+#endif
@@ -0,0 +1,280 @@
+#ifndef _PERFECTCLEAR_H_
+#define _PERFECTCLEAR_H_
+
+#include "tetris.h"
+#include "movegen.h"
+#include "parallel.h"
+#include "ai.h"
+#include "compactboard.h"
+
+#include <atomic>
+#include <unordered_set>
+#include <vector>
+
+// Perfect clears: sequences of placements, one per upcoming piece in order,
+// that leave the board empty.
+//
+// The search tries clears of 1 to maxHeight rows, lowest first. For a clear
+// of h rows every piece has to land inside the bottom h rows (fewer as lines
+// are cleared), and a node is only expanded when:
+//
+// - the empty cells in those rows are a multiple of 4, and there are enough
+//   pieces left to fill them
+// - every run of columns between columns filled to the top of those rows has
+//   a multiple of 4 empty cells, since pieces cannot cross such a column
+// - they can be filled with the right pieces by column parity. Colouring
+//   columns alternately, O, S, Z and I pieces cover as many cells of each
+//   colour (or four of one), L and J always cover three of one colour and one
+//   of the other, and T covers either. Line clears take as many cells of
+//   each colour, so the difference must be reachable with the pieces used.
+//
+// Boards that failed are remembered per depth, keyed by the first word of
+// their CompactBoard, which holds every row of a board this low. The first
+// moves are searched in parallel, and the result is always the solution
+// under the earliest first move that has one, so it does not depend on the
+// number of threads.
+
+struct PerfectClearOptions {
+  int maxHeight = 4;
+  MoveSet moves = MoveSet::HardDrops;
+
+  // 0 for as many as there are hardware threads.
+  int threads = 0;
+};
+
+struct PerfectClearResult {
+  std::vector<DropMove> moves;
+  long nodes = 0;
+
+  bool found() const { return !moves.empty(); }
+};
+
+template <typename B>
+class PerfectClearSearch {
+private:
+  const std::vector<PieceType> &pieces;
+  MoveSet moves;
+  std::vector<std::unordered_set<uint64_t>> failed;
+
+  const std::atomic<int> *solved;
+  int branch;
+
+  bool aborted() const {
+    return solved->load(std::memory_order_relaxed) < branch;
+  }
+
+  static constexpr typename B::Row evenColumns() {
+    typename B::Row mask = 0;
+    for (int j = 0; j < B::width(); j += 2) mask |= typename B::Row(1) << j;
+    return mask;
+  }
+
+  bool feasible(const B &board, int depth, int rows) const {
+    if (board.stackHeight() > rows) return false;
+
+    int empty = 0, parity = 0;
+    auto walls = B::fullRow;
+    for (int i = B::height()-rows; i < B::height(); i++) {
+      auto r = ~board.row(i) & B::fullRow;
+      int even = bitCount(typename B::Row(r & evenColumns()));
+      int odd = bitCount(typename B::Row(r & ~evenColumns()));
+      empty += even + odd;
+      parity += even - odd;
+      walls &= board.row(i);
+    }
+
+    int needed = empty/4;
+    if (empty % 4 != 0 || depth + needed > (int)pieces.size()) return false;
+
+    // No piece can cross a column that is filled in every row, and line
+    // clears keep it filled, so each side has to be filled on its own.
+    for (int left = 0; walls != 0; ) {
+      int wall = lowestBit(walls);
+      walls &= walls-1;
+
+      auto columns = typename B::Row(((typename B::Row(1) << wall) - 1) & ~((typename B::Row(1) << left) - 1));
+      int cells = 0;
+      for (int i = B::height()-rows; i < B::height(); i++) cells += bitCount(typename B::Row(~board.row(i) & columns));
+      if (cells % 4 != 0) return false;
+
+      left = wall+1;
+    }
+
+    int reach = 0, forced = 0;
+    bool flexible = false;
+    for (int k = depth; k < depth + needed; k++) {
+      switch (pieces[k]) {
+        case I: reach += 4; break;
+        case L: case J: reach += 2; forced++; break;
+        case T: reach += 2; flexible = true; break;
+        default: break;
+      }
+    }
+
+    if (parity < -reach || parity > reach) return false;
+    return flexible || (parity/2 - forced) % 2 == 0;
+  }
+
+  bool search(const B &board, int depth, int rows) {
+    nodes++;
+    if (aborted() || !feasible(board, depth, rows)) return false;
+
+    auto k = BasicCompactBoard<B>::bottomWord(board);
+    if (failed[depth].count(k) != 0) return false;
+
+    auto piece = pieces[depth];
+    bool found = false;
+
+    enumerateMoves(board, piece, moves,
+        [&](DropMove move) {
+          if (found) return;
+
+          int row = board.getDropRow(piece, move);
+          if (row < B::height()-rows) return;
+
+          B next = board;
+          auto played = next.playMove(piece, move);
+          if (!played.valid()) return;
+
+          if (next.stackHeight() == 0 || search(next, depth+1, rows-played.linesCleared)) {
+            path.push_back(move);
+            found = true;
+          }
+        });
+
+    if (!found && !aborted()) failed[depth].insert(k);
+    return found;
+  }
+
+public:
+  // Moves after the first, last move first.
+  std::vector<DropMove> path;
+  long nodes = 0;
+
+  PerfectClearSearch(const std::vector<PieceType> &pieces, MoveSet moves):
+    pieces(pieces), moves(moves), failed(pieces.size()), solved(nullptr), branch(0) {}
+
+  void reset() {
+    for (auto &f : failed) f.clear();
+  }
+
+  // Searches from the board left by the first move, which cleared down to
+  // rows rows.
+  bool solve(const B &board, int rows, const std::atomic<int> &solved, int branch) {
+    this->solved = &solved;
+    this->branch = branch;
+    path.clear();
+
+    return board.stackHeight() == 0 || search(board, 1, rows);
+  }
+};
+
+template <typename B>
+PerfectClearResult findPerfectClear(const B &board, const std::vector<PieceType> &pieces,
+                                    const PerfectClearOptions &options = {}) {
+  PerfectClearResult result;
+  if (pieces.empty()) return result;
+
+  int filled = 0;
+  for (int i = 0; i < B::height(); i++) filled += bitCount(board.row(i));
+
+  int threads = defaultThreads(options.threads);
+  std::vector<PerfectClearSearch<B>> searches(threads, PerfectClearSearch<B>(pieces, options.moves));
+
+  for (int rows = std::max(1, board.stackHeight()); rows <= options.maxHeight; rows++) {
+    int empty = rows*B::width() - filled;
+    if (empty % 4 != 0 || empty/4 > (int)pieces.size() || rows*B::width() > 64) continue;
+
+    std::vector<DropMove> first;
+    std::vector<B> boards;
+    std::vector<int> remaining;
+
+    enumerateMoves(board, pieces[0], options.moves,
+        [&](DropMove move) {
+          if (board.getDropRow(pieces[0], move) < B::height()-rows) return;
+
+          B next = board;
+          auto played = next.playMove(pieces[0], move);
+          if (!played.valid()) return;
+
+          first.push_back(move);
+          boards.push_back(next);
+          remaining.push_back(rows-played.linesCleared);
+        });
+
+    std::atomic<int> solved((int)first.size());
+    std::vector<std::vector<DropMove>> paths(first.size());
+    for (auto &search : searches) search.reset();
+
+    parallelFor((int)first.size(), threads,
+        [&](int i, int thread) {
+          auto &search = searches[thread];
+          if (!search.solve(boards[i], remaining[i], solved, i)) return;
+
+          paths[i] = search.path;
+          for (int s = solved.load(); i < s && !solved.compare_exchange_weak(s, i); ) {}
+        });
+
+    for (const auto &search : searches) result.nodes += search.nodes;
+    for (auto &search : searches) search.nodes = 0;
+
+    int best = solved.load();
+    if (best < (int)first.size()) {
+      result.moves.push_back(first[best]);
+      result.moves.insert(result.moves.end(), paths[best].rbegin(), paths[best].rend());
+      return result;
+    }
+  }
+
+  return result;
+}
+
+// Plays perfect clears when one can be found within the preview, and
+// otherwise leaves the move to Fallback. Once a clear is found its moves are
+// played out without searching again.
+template <typename Fallback>
+class PerfectClearPlayer {
+private:
+  Fallback fallback;
+  PerfectClearOptions options;
+
+  std::vector<PieceType> pieces;
+  std::vector<DropMove> plan;
+  size_t next = 0;
+
+public:
+  explicit PerfectClearPlayer(const PlayerOptions &player = {}): fallback{player.moves} {
+    options.moves = player.moves;
+    options.threads = player.threads;
+  }
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) {
+    return fallback(board, piece);
+  }
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece, const PiecePreview &preview) {
+    if (next < plan.size()) {
+      auto move = plan[next++];
+      if (board.getDropRow(piece, move) >= 0) return move;
+      plan.clear();
+    }
+
+    if (board.stackHeight() <= options.maxHeight) {
+      pieces.assign(1, piece);
+      pieces.insert(pieces.end(), preview.pieces.begin(), preview.pieces.begin()+preview.count);
+
+      auto clear = findPerfectClear(board, pieces, options);
+      if (clear.found()) {
+        plan = std::move(clear.moves);
+        next = 1;
+        return plan[0];
+      }
+    }
+
+    return fallback(board, piece);
+  }
+};
+
+#endif
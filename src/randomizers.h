@@ -3,18 +3,176 @@
 
 #include "tetris.h"
 
+#include <array>
+#include <random>
+#include <algorithm>
+
+const std::array<PieceType, 7> allPieces = {I, O, T, L, J, S, Z};
+
+// Each randomizer is a concrete type constructed from a seed and called to
+// produce the next piece, so Game can be specialised on it. The functions
+// below wrap them as PieceGenerator for callers that pick one at runtime.
+// Randomizers compare equal when they will deal the same pieces from then on.
+
 // This basically generates a random number between 0 and 6, and use that
 // as an index to a lookup table.
-PieceGenerator uniform(int seed);
+struct UniformRandomizer {
+  std::default_random_engine rng;
+
+  explicit UniformRandomizer(int seed): rng(std::default_random_engine(seed)) {}
+
+  PieceType operator()() {
+    int i = std::uniform_int_distribution<int>(0, 6)(rng);
+    return allPieces[i];
+  }
+
+  bool operator==(const UniformRandomizer &r) const { return rng == r.rng; }
+};
+
+// Uniform pieces from a SplitMix64 stream. Seeding is free and nearby seeds
+// give unrelated streams, so simulations can give every rollout its own.
+struct StreamRandomizer {
+  uint64_t state;
+
+  explicit StreamRandomizer(uint64_t seed): state(seed) {}
+
+  uint64_t next() {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  PieceType operator()() {
+    return allPieces[((next() >> 32) * 7) >> 32];
+  }
+
+  bool operator==(const StreamRandomizer &r) const { return state == r.state; }
+};
+
+inline uint16_t nextRandomNumber(uint16_t value) {
+  return ((((value >> 9) & 1) ^ ((value >> 1) & 1)) << 15) | (value >> 1);
+}
 
 // Randomizer used by NES Tetris, which uses LFSR to generate random numbers.
-PieceGenerator nes(int seed);
+struct NesRandomizer {
+  uint16_t rand;
+  uint8_t spawnCount;
+  int prevSpawnId;
+
+  explicit NesRandomizer(int seed): rand(nextRandomNumber(seed % 32767)), spawnCount(0), prevSpawnId(0) {}
+
+  PieceType operator()() {
+    static constexpr std::array<PieceType, 7> nesSpawnTable = {T, J, Z, O, S, L, I};
+    static constexpr std::array<uint8_t, 7> nesSpawnOrientationTable = {0x02, 0x07, 0x08, 0x0a, 0x0b, 0x0e, 0x12};
+
+    uint8_t acc;
+    int newSpawnId;
+    PieceType piece;
+
+    rand = nextRandomNumber(rand);
+    spawnCount++;
+
+    acc = (rand >> 8);
+    acc += spawnCount;
+    acc &= 7;
+
+    if (acc == 7) goto invalidIndex;
+
+    piece = nesSpawnTable[acc];
+    newSpawnId = (int)nesSpawnOrientationTable[acc];
+    if (newSpawnId != prevSpawnId) {
+      goto useNewSpawnId;
+    }
+
+invalidIndex:
+    rand = nextRandomNumber(rand);
+    acc = (rand >> 8);
+    acc &= 7;
+    acc += prevSpawnId;
+    acc %= 7;
+
+    piece = nesSpawnTable[acc];
+    newSpawnId = (int)nesSpawnOrientationTable[acc];
+
+useNewSpawnId:
+    prevSpawnId = newSpawnId;
+    return piece;
+  }
+
+  // Only the low 3 bits of spawnCount affect the pieces dealt, and it wraps
+  // at 256, so states differing above them deal the same pieces forever.
+  bool operator==(const NesRandomizer &r) const {
+    return rand == r.rand && (spawnCount & 7) == (r.spawnCount & 7) && prevSpawnId == r.prevSpawnId;
+  }
+};
 
 // Randomizer used by NES Tetris, but approximated as first-order Markov process.
-PieceGenerator nesApprox(int seed);
+struct NesApproxRandomizer {
+  std::default_random_engine rng;
+  PieceType prev;
+
+  explicit NesApproxRandomizer(int seed);
+
+  // Continues after prev, e.g. from a piece seen in an NES game.
+  NesApproxRandomizer(int seed, PieceType prev): rng(std::default_random_engine(seed)), prev(prev) {}
+
+  PieceType operator()();
+
+  bool operator==(const NesApproxRandomizer &r) const { return rng == r.rng && prev == r.prev; }
+};
 
 // All 7 pieces are randomly shuffled inside a bag.
 // This randomizer produces the most uniform distribution.
+struct SevenBagRandomizer {
+  std::default_random_engine rng;
+  std::array<PieceType, 7> pieces;
+  int bagIndex;
+
+  explicit SevenBagRandomizer(int seed):
+    rng(std::default_random_engine(seed)),
+    pieces(allPieces),
+    bagIndex(7) {}
+
+  // Deals the rest of a bag first, dealt being the mask of the pieces
+  // already dealt from it.
+  SevenBagRandomizer(int seed, uint8_t dealt): SevenBagRandomizer(seed) {
+    int count = 0;
+    for (int p = 0; p < 7; p++) {
+      if ((dealt >> p) & 1) pieces[count++] = PieceType(p);
+    }
+    if (count == 7) return;
+
+    bagIndex = count;
+    for (int p = 0; p < 7; p++) {
+      if (((dealt >> p) & 1) == 0) pieces[count++] = PieceType(p);
+    }
+    std::shuffle(pieces.begin()+bagIndex, pieces.end(), rng);
+  }
+
+  void generate() {
+    pieces[0] = I; pieces[1] = O; pieces[2] = T;
+    pieces[3] = L; pieces[4] = J;
+    pieces[5] = S; pieces[6] = Z;
+    std::shuffle(pieces.begin(), pieces.end(), rng);
+    bagIndex = 0;
+  }
+
+  PieceType operator()() {
+    if (bagIndex == 7) generate();
+    return pieces[bagIndex++];
+  }
+
+  // The pieces already dealt from the bag make no difference.
+  bool operator==(const SevenBagRandomizer &r) const {
+    return rng == r.rng && bagIndex == r.bagIndex &&
+      std::equal(pieces.begin()+bagIndex, pieces.end(), r.pieces.begin()+bagIndex);
+  }
+};
+
+PieceGenerator uniform(int seed);
+PieceGenerator nes(int seed);
+PieceGenerator nesApprox(int seed);
 PieceGenerator sevenBag(int seed);
 
 #endif
@@ -0,0 +1,158 @@
+#ifndef _ROWKERNELS_H_
+#define _ROWKERNELS_H_
+
+#include "tetris.h"
+
+// Row-local quantities of a W-wide row, with the walls on both sides counting
+// as filled:
+//
+// - transitions(r): filled/empty changes along the row
+// - wells(r): mask of empty cells whose left and right neighbours are filled
+// - count(mask): number of cells set in a mask
+//
+// CellLoopRowKernels visits one cell at a time, BitwiseRowKernels uses shifts
+// and popcount, and TableRowKernels looks results up in tables built at
+// compile time. DefaultRowKernels picks the fastest mix for the width.
+
+template <int W>
+struct CellLoopRowKernels {
+  using Row = BoardRow<W>;
+
+  static int transitions(Row r) {
+    int transitions = 0;
+    int last = 1;
+    int current = 0;
+
+    for (int j = 0; j < W; j++) {
+      current = (r >> j) & 1;
+      if (current != last) transitions++;
+
+      last = current;
+    }
+
+    if (current == 0) transitions++;
+    return transitions;
+  }
+
+  static Row wells(Row r) {
+    Row wells = 0;
+    for (int j = 0; j < W; j++) {
+      int left = j > 0 ? (r >> (j-1)) & 1 : 1;
+      int right = j < W-1 ? (r >> (j+1)) & 1 : 1;
+      if (((r >> j) & 1) == 0 && left == 1 && right == 1) wells |= Row(1) << j;
+    }
+    return wells;
+  }
+
+  static int count(Row mask) {
+    int count = 0;
+    for (int j = 0; j < W; j++) {
+      count += (mask >> j) & 1;
+    }
+    return count;
+  }
+};
+
+template <int W>
+struct BitwiseRowKernels {
+  using Row = BoardRow<W>;
+
+  static constexpr Row fullRow = Row(~Row(0)) >> (8*sizeof(Row) - W);
+
+  static constexpr int transitions(Row r) {
+    return bitCount(Row((r ^ ((r << 1) | 1)) & fullRow)) + (((r >> (W-1)) & 1) ^ 1);
+  }
+
+  static constexpr Row wells(Row r) {
+    return Row(~r & ((r << 1) | 1) & ((r >> 1) | (Row(1) << (W-1))) & fullRow);
+  }
+
+  static constexpr int count(Row mask) {
+    return bitCount(mask);
+  }
+};
+
+template <int W, typename T, typename Fn>
+constexpr std::array<T, (1 << W)> makeRowTable(Fn fn) {
+  std::array<T, (1 << W)> table {};
+  for (int r = 0; r < (1 << W); r++) table[r] = T(fn(r));
+  return table;
+}
+
+// One entry per possible row value. For the 10-wide board the three tables
+// take 4KB in total, so they stay resident in L1. A table over adjacent row
+// pairs would take 1M entries, which no longer fits in L2.
+template <int W>
+struct TableRowKernels {
+  static_assert(W <= 12, "row tables are only built for boards up to 12 wide");
+
+  using Row = BoardRow<W>;
+  using Bitwise = BitwiseRowKernels<W>;
+
+  static constexpr std::array<uint8_t, (1 << W)> transitionTable =
+    makeRowTable<W, uint8_t>([](int r) { return Bitwise::transitions(r); });
+
+  static constexpr std::array<Row, (1 << W)> wellTable =
+    makeRowTable<W, Row>([](int r) { return Bitwise::wells(r); });
+
+  static constexpr std::array<uint8_t, (1 << W)> countTable =
+    makeRowTable<W, uint8_t>([](int r) { return Bitwise::count(r); });
+
+  static int transitions(Row r) { return transitionTable[r]; }
+  static Row wells(Row r) { return wellTable[r]; }
+  static int count(Row mask) { return countTable[mask]; }
+};
+
+// Tables for transitions and wells, but popcnt for counting, which
+// --mode bench-rows measures as faster than a table lookup.
+template <int W>
+struct MixedRowKernels : TableRowKernels<W> {
+  static int count(BoardRow<W> mask) { return bitCount(mask); }
+};
+
+template <int W>
+using DefaultRowKernels = std::conditional_t<(W <= 12), MixedRowKernels<W>, BitwiseRowKernels<W>>;
+
+// Whole-board El-Tetris row features built on the kernels above.
+
+template <typename K, typename B>
+int rowTransitions(const B &board) {
+  int transitions = 0;
+  for (int i = 0; i < B::height(); i++) {
+    transitions += K::transitions(board.row(i));
+  }
+  return transitions;
+}
+
+// A hole is an empty cell with a filled cell anywhere above it.
+template <typename K, typename B>
+int rowHoles(const B &board) {
+  int holes = 0;
+  typename B::Row covered = board.row(0);
+
+  for (int i = 1; i < B::height(); i++) {
+    holes += K::count(~board.row(i) & covered & B::fullRow);
+    covered |= board.row(i);
+  }
+
+  return holes;
+}
+
+// Each well cell counts itself plus the run of empty cells below it.
+template <typename K, typename B>
+int rowWellSums(const B &board) {
+  int sums = 0;
+
+  for (int i = 0; i < B::height(); i++) {
+    for (auto wells = K::wells(board.row(i)); wells != 0; wells &= wells-1) {
+      int j = lowestBit(wells);
+
+      sums++;
+      for (int k = i+1; k < B::height() && board.cell(k, j) == 0; k++) sums++;
+    }
+  }
+
+  return sums;
+}
+
+#endif
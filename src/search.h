@@ -0,0 +1,140 @@
+#ifndef _SEARCH_H_
+#define _SEARCH_H_
+
+#include "tetris.h"
+#include "evaluator.h"
+#include "compactboard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Expectimax over the pieces to come, drawn uniformly. At depth 1 this is
+// greedyMove. Deeper, only the beam best placements by the evaluator are
+// expanded, each valued at the mean over the 7 next pieces of their best
+// placement one level down, so the scores at every depth are on the
+// evaluator's scale.
+//
+// Different placements can lead to the same board, so the values of
+// expected() are kept per depth in a table of CompactBoards for the life of
+// the search, which covers every depth of an iterative deepening. Values
+// from an aborted search are not kept.
+//
+// A search can be given a deadline, after which it gives up and returns
+// topOut from every level. The clock is only read every clockInterval
+// placements, which is a few microseconds of work.
+template <typename E, typename B>
+class ExpectimaxSearch {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Value of a board where the piece cannot be placed.
+  static constexpr double topOut = -1e9;
+
+  static constexpr long clockInterval = 16;
+
+  struct Candidate {
+    DropMove move;
+    double score;
+  };
+
+private:
+  const E &evaluator;
+  int beam;
+  MoveSet moves;
+
+  Clock::time_point deadline = Clock::time_point::max();
+
+  std::vector<std::unordered_map<BasicCompactBoard<B>, double>> table;
+
+  void candidates(const B &board, PieceType piece, std::vector<Candidate> &out) {
+    IncrementalEvaluator<E, B> candidates(evaluator, board);
+
+    enumerateMoves(board, piece, moves,
+        [&](DropMove move) {
+          if (aborted) return;
+          if (++nodes % clockInterval == 0 && Clock::now() >= deadline) {
+            aborted = true;
+            return;
+          }
+
+          auto eval = candidates.evaluate(piece, move);
+          if (eval.valid) out.push_back({ move, eval.score });
+        });
+  }
+
+public:
+  long nodes = 0;
+  bool aborted = false;
+
+  ExpectimaxSearch(const E &evaluator, int beam = 4, MoveSet moves = MoveSet::HardDrops):
+    evaluator(evaluator), beam(beam), moves(moves) {}
+
+  // Best placement of piece looking depth-1 pieces further ahead.
+  std::pair<DropMove, double> best(const B &board, PieceType piece, int depth) {
+    std::vector<Candidate> options;
+    candidates(board, piece, options);
+    if (aborted || options.empty()) return { DropMove::invalid(), topOut };
+
+    std::stable_sort(options.begin(), options.end(),
+        [](const Candidate &a, const Candidate &b) { return a.score > b.score; });
+    if (depth <= 1) return { options[0].move, options[0].score };
+
+    if ((int)options.size() > beam) options.erase(options.begin()+beam, options.end());
+
+    std::pair<DropMove, double> best = { DropMove::invalid(), topOut };
+    for (const auto &option : options) {
+      B next = board;
+      next.playMove(piece, option.move);
+
+      double value = expected(next, depth-1);
+      if (aborted) return { DropMove::invalid(), topOut };
+      if (!best.first.valid() || value > best.second) best = { option.move, value };
+    }
+
+    return best;
+  }
+
+  // Mean over the next piece of its best placement.
+  double expected(const B &board, int depth) {
+    if (depth >= (int)table.size()) table.resize(depth+1);
+    BasicCompactBoard<B> key(board);
+    auto found = table[depth].find(key);
+    if (found != table[depth].end()) return found->second;
+
+    double sum = 0;
+    for (int p = 0; p < 7 && !aborted; p++) sum += best(board, PieceType(p), depth).second;
+    if (!aborted) table[depth].emplace(key, sum / 7);
+    return sum / 7;
+  }
+
+  struct Deepening {
+    DropMove move;
+    int depth;
+  };
+
+  // Iterative deepening: searches depth 1, 2, ... up to maxDepth, and when
+  // the deadline passes returns the move of the deepest search that
+  // finished. Depth 1 always runs to the end, so there is always a move.
+  Deepening deepen(const B &board, PieceType piece, int maxDepth, Clock::time_point deadline) {
+    this->deadline = Clock::time_point::max();
+    aborted = false;
+
+    Deepening result = { best(board, piece, 1).first, 1 };
+    if (!result.move.valid()) return result;
+
+    this->deadline = deadline;
+    for (int depth = 2; depth <= maxDepth; depth++) {
+      auto move = best(board, piece, depth).first;
+      if (aborted) break;
+      result = { move, depth };
+    }
+
+    this->deadline = Clock::time_point::max();
+    return result;
+  }
+};
+
+#endif
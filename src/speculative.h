@@ -0,0 +1,135 @@
+#ifndef _SPECULATIVE_H_
+#define _SPECULATIVE_H_
+
+#include "tetris.h"
+#include "ai.h"
+#include "parallel.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+// Wraps a player so that as soon as it has chosen a move, the answers to all
+// 7 possible next pieces on the resulting board are worked out on a thread
+// pool. When the next piece arrives on that board its answer comes from the
+// cache, waiting for it if a worker is still on it, and the searches for the
+// other pieces that have not started yet are dropped. If no worker has got
+// to it yet, or the board is different (e.g. a hold swapped the piece in),
+// the player is asked directly.
+//
+// Inner is called from several threads at once, so it must be safe to call
+// concurrently through a const reference. Answers are the same as Inner's.
+template <typename Inner>
+class Speculative {
+private:
+  using Clock = std::chrono::steady_clock;
+
+  enum SlotStatus { Pending, Running, Done, Dropped };
+
+  struct Slot {
+    std::atomic<int> status { Pending };
+    DropMove move = DropMove::invalid();
+    double micros = 0;
+  };
+
+  // One per move played. Workers hold on to it, so a batch that is no
+  // longer wanted can finish in the background without getting in the way
+  // of the next one.
+  template <typename B>
+  struct Batch {
+    B board;
+    std::array<Slot, 7> slots;
+  };
+
+  template <typename B>
+  using BatchPtr = std::shared_ptr<Batch<B>>;
+
+  std::shared_ptr<const Inner> inner;
+  std::unique_ptr<ThreadPool> pool;
+
+  // BatchPtr<B> for the board type of the game.
+  std::shared_ptr<void> batch;
+
+  long hits = 0, misses = 0;
+  double hitMicros = 0, missMicros = 0, savedMicros = 0;
+
+  template <typename B>
+  void speculate(const B &board, PieceType piece, DropMove move) {
+    auto next = std::make_shared<Batch<B>>();
+    next->board = board;
+    if (!next->board.playMove(piece, move).valid()) return;
+
+    for (int p = 0; p < 7; p++) {
+      pool->submit([next, inner = inner, p] {
+        auto &slot = next->slots[p];
+        int pending = Pending;
+        if (!slot.status.compare_exchange_strong(pending, Running)) return;
+
+        auto start = Clock::now();
+        slot.move = (*inner)(next->board, PieceType(p));
+        slot.micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        slot.status.store(Done, std::memory_order_release);
+      });
+    }
+
+    batch = std::make_shared<BatchPtr<B>>(next);
+  }
+
+public:
+  explicit Speculative(const PlayerOptions &options = {}):
+    inner(std::make_shared<const Inner>(options)),
+    pool(std::make_unique<ThreadPool>(std::min(defaultThreads(options.threads), 7))) {}
+
+  Speculative(Speculative &&) = default;
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) {
+    auto start = Clock::now();
+
+    BatchPtr<B> current;
+    if (batch) current = *static_cast<BatchPtr<B> *>(batch.get());
+    batch.reset();
+
+    bool hit = false;
+    if (current && current->board == board) {
+      // Nothing not yet started is wanted any more, including this piece
+      // if no worker has picked it up.
+      for (int p = 0; p < 7; p++) {
+        int pending = Pending;
+        current->slots[p].status.compare_exchange_strong(pending, Dropped);
+      }
+
+      auto &slot = current->slots[piece];
+      while (slot.status.load(std::memory_order_acquire) == Running) std::this_thread::yield();
+      hit = slot.status.load(std::memory_order_acquire) == Done;
+    }
+
+    auto move = hit ? current->slots[piece].move : (*inner)(board, piece);
+
+    double micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    if (hit) {
+      hits++;
+      hitMicros += micros;
+      savedMicros += current->slots[piece].micros - micros;
+    } else {
+      misses++;
+      missMicros += micros;
+    }
+
+    if (move.valid()) speculate(board, piece, move);
+    return move;
+  }
+
+  void report(std::ostream &out) const {
+    long decisions = hits + misses;
+    out << "threads=" << pool->size() << ", decisions=" << decisions << ", hits=" << hits
+      << ", hit_rate=" << (decisions > 0 ? (double)hits/decisions : 0) << std::endl;
+    out << "hit_us=" << (hits > 0 ? hitMicros/hits : 0)
+      << ", miss_us=" << (misses > 0 ? missMicros/misses : 0)
+      << ", saved_us_per_hit=" << (hits > 0 ? savedMicros/hits : 0) << std::endl;
+  }
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+void RunningStats::merge(const RunningStats &other) {
+  if (other.n == 0) return;
+  if (n == 0) {
+    *this = other;
+    return;
+  }
+
+  long combined = n + other.n;
+  double delta = other.mu - mu;
+  mu += delta * other.n / combined;
+  m2 += other.m2 + delta * delta * n * other.n / combined;
+  n = combined;
+  lo = std::min(lo, other.lo);
+  hi = std::max(hi, other.hi);
+}
+
+double RunningStats::stddev() const {
+  return std::sqrt(variance());
+}
+
+void QuantileSketch::insert(Centroid c) {
+  buffer.push_back(c);
+  total += c.weight;
+  lo = std::min(lo, c.mean);
+  hi = std::max(hi, c.mean);
+  if (buffer.size() == bufferSize) compress();
+}
+
+void QuantileSketch::compress() {
+  if (buffer.empty()) return;
+
+  buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+  std::sort(buffer.begin(), buffer.end(), [](const Centroid &a, const Centroid &b) { return a.mean < b.mean; });
+
+  auto k = [&](double q) { return compression / (2 * M_PI) * std::asin(2 * q - 1); };
+  auto kInverse = [&](double k) { return (std::sin(k * 2 * M_PI / compression) + 1) / 2; };
+
+  centroids.clear();
+  double before = 0;
+  double limit = kInverse(k(0) + 1) * total;
+  Centroid current = buffer[0];
+
+  for (size_t i = 1; i < buffer.size(); i++) {
+    const auto &c = buffer[i];
+    if (before + current.weight + c.weight <= limit) {
+      current.weight += c.weight;
+      current.mean += (c.mean - current.mean) * c.weight / current.weight;
+    } else {
+      before += current.weight;
+      centroids.push_back(current);
+      limit = kInverse(k(before / total) + 1) * total;
+      current = c;
+    }
+  }
+  centroids.push_back(current);
+
+  buffer.clear();
+}
+
+void QuantileSketch::merge(const QuantileSketch &other) {
+  for (const auto &c : other.centroids) insert(c);
+  for (const auto &c : other.buffer) insert(c);
+}
+
+double QuantileSketch::quantile(double q) const {
+  if (total == 0) return 0;
+
+  auto sketch = *this;
+  sketch.compress();
+  const auto &cs = sketch.centroids;
+
+  // Each centroid stands for its weight spread evenly around its mean, so
+  // the weight below its mean is the weight of those before it plus half its
+  // own. Between those points, and out to the extremes, interpolate.
+  double target = std::clamp(q, 0.0, 1.0) * total;
+  double before = 0;
+  double prevMean = lo, prevCenter = 0;
+
+  for (const auto &c : cs) {
+    double center = before + c.weight / 2;
+    if (target < center) {
+      if (center == prevCenter) return c.mean;
+      return prevMean + (c.mean - prevMean) * (target - prevCenter) / (center - prevCenter);
+    }
+    before += c.weight;
+    prevMean = c.mean;
+    prevCenter = center;
+  }
+
+  if (total == prevCenter) return hi;
+  return prevMean + (hi - prevMean) * (target - prevCenter) / (total - prevCenter);
+}
@@ -0,0 +1,97 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Summaries of a stream of values in constant memory, for runs of more games
+// than are worth keeping the results of. Each thread fills its own and they
+// are merged at the end, in any order.
+
+// Count, mean, variance and range, updated with Welford's method and merged
+// with Chan et al.'s formula, both of which stay accurate where summing
+// squares would cancel.
+class RunningStats {
+private:
+  long n = 0;
+  double mu = 0, m2 = 0;
+  double lo = std::numeric_limits<double>::infinity();
+  double hi = -std::numeric_limits<double>::infinity();
+
+public:
+  void add(double x) {
+    n++;
+    double delta = x - mu;
+    mu += delta / n;
+    m2 += delta * (x - mu);
+    if (x < lo) lo = x;
+    if (x > hi) hi = x;
+  }
+
+  void merge(const RunningStats &other);
+
+  long count() const { return n; }
+  double mean() const { return mu; }
+  // Sample variance.
+  double variance() const { return n > 1 ? m2 / (n-1) : 0; }
+  double stddev() const;
+  double min() const { return lo; }
+  double max() const { return hi; }
+};
+
+// Approximate quantiles, as a merging t-digest: values are buffered, and a
+// full buffer is sorted into the centroids, each the mean and weight of a run
+// of neighbouring values. Centroids are kept small near the ends, where the
+// scale function k(q) = compression / (2 pi) * asin(2q - 1) is steep, so
+// the tails are resolved to a few values while the middle is coarser. There
+// are never more than about compression centroids, however many values were
+// added.
+class QuantileSketch {
+private:
+  struct Centroid {
+    double mean, weight;
+  };
+
+  static constexpr size_t bufferSize = 512;
+
+  double compression;
+  std::vector<Centroid> centroids;
+  std::vector<Centroid> buffer;
+  double total = 0;
+  double lo = std::numeric_limits<double>::infinity();
+  double hi = -std::numeric_limits<double>::infinity();
+
+  void insert(Centroid c);
+  void compress();
+
+public:
+  explicit QuantileSketch(double compression = 100): compression(compression) {
+    buffer.reserve(bufferSize);
+  }
+
+  void add(double x) { insert({ x, 1 }); }
+  void merge(const QuantileSketch &other);
+
+  // The value with a fraction q of the weight below it, interpolated between
+  // centroids. 0 if nothing was added.
+  double quantile(double q) const;
+};
+
+// Both of the above for one stream.
+struct Distribution {
+  RunningStats stats;
+  QuantileSketch quantiles;
+
+  void add(double x) {
+    stats.add(x);
+    quantiles.add(x);
+  }
+
+  void merge(const Distribution &other) {
+    stats.merge(other.stats);
+    quantiles.merge(other.quantiles);
+  }
+};
+
+#endif
@@ -7,6 +7,12 @@
 #include <string>
 #include <functional>
 #include <map>
+#include <iostream>
+#include <cstdint>
+#include <type_traits>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
 
 enum PieceType {
   I = 0,
@@ -18,48 +24,88 @@ enum PieceType {
 using PieceGenerator = std::function<PieceType()>;
 using PieceRandomizer = std::function<PieceGenerator(int seed)>;
 
-const std::map<PieceType, int> pieceRotations = {
-  { PieceType::I, 2 },
-  { PieceType::O, 1 },
-  { PieceType::T, 4 },
-  { PieceType::L, 4 },
-  { PieceType::J, 4 },
-  { PieceType::S, 2 },
-  { PieceType::Z, 2 },
+// Each rotation of a piece is stored as up to 4 rows (top to bottom) of bits,
+// where bit 0 is the leftmost column of the piece's bounding box.
+struct PieceShape {
+  std::array<uint16_t, 4> rows;
+  int width, height;
 };
 
-const std::map<std::pair<PieceType, int>, std::pair<int, int>> pieceSizes = {
-  { { PieceType::I, 0 }, {4, 1} },
-  { { PieceType::I, 1 }, {1, 4} },
-
-  { { PieceType::O, 0 }, {2, 2} },
-
-  { { PieceType::T, 0 }, {3, 2} },
-  { { PieceType::T, 1 }, {2, 3} },
-  { { PieceType::T, 2 }, {3, 2} },
-  { { PieceType::T, 3 }, {2, 3} },
-
-  { { PieceType::L, 0 }, {3, 2} },
-  { { PieceType::L, 1 }, {2, 3} },
-  { { PieceType::L, 2 }, {3, 2} },
-  { { PieceType::L, 3 }, {2, 3} },
-
-  { { PieceType::J, 0 }, {3, 2} },
-  { { PieceType::J, 1 }, {2, 3} },
-  { { PieceType::J, 2 }, {3, 2} },
-  { { PieceType::J, 3 }, {2, 3} },
-
-  { { PieceType::S, 0 }, {3, 2} },
-  { { PieceType::S, 1 }, {2, 3} },
-
-  { { PieceType::Z, 0 }, {3, 2} },
-  { { PieceType::Z, 1 }, {2, 3} },
+struct PieceRotations {
+  std::array<PieceShape, 4> rotations;
+  int count;
 };
 
+inline constexpr std::array<PieceRotations, 7> pieceShapes = {{
+  // I
+  { {{
+      { { 0b1111 }, 4, 1 },
+      { { 0b1, 0b1, 0b1, 0b1 }, 1, 4 },
+    }}, 2 },
+
+  // O
+  { {{
+      { { 0b11, 0b11 }, 2, 2 },
+    }}, 1 },
+
+  // T
+  { {{
+      { { 0b111, 0b010 }, 3, 2 },
+      { { 0b01, 0b11, 0b01 }, 2, 3 },
+      { { 0b010, 0b111 }, 3, 2 },
+      { { 0b10, 0b11, 0b10 }, 2, 3 },
+    }}, 4 },
+
+  // L
+  { {{
+      { { 0b001, 0b111 }, 3, 2 },
+      { { 0b10, 0b10, 0b11 }, 2, 3 },
+      { { 0b111, 0b100 }, 3, 2 },
+      { { 0b11, 0b01, 0b01 }, 2, 3 },
+    }}, 4 },
+
+  // J
+  { {{
+      { { 0b100, 0b111 }, 3, 2 },
+      { { 0b11, 0b10, 0b10 }, 2, 3 },
+      { { 0b111, 0b001 }, 3, 2 },
+      { { 0b01, 0b01, 0b11 }, 2, 3 },
+    }}, 4 },
+
+  // S
+  { {{
+      { { 0b011, 0b110 }, 3, 2 },
+      { { 0b10, 0b11, 0b01 }, 2, 3 },
+    }}, 2 },
+
+  // Z
+  { {{
+      { { 0b110, 0b011 }, 3, 2 },
+      { { 0b01, 0b11, 0b10 }, 2, 3 },
+    }}, 2 },
+}};
+
+inline constexpr int pieceRotations(PieceType piece) {
+  return pieceShapes[piece].count;
+}
+
+inline constexpr const PieceShape &pieceShape(PieceType piece, int rot) {
+  return pieceShapes[piece].rotations[rot];
+}
+
+// By default the piece is hard dropped from the top in the given column and
+// rotation. With row set, it is placed with its top at that row instead,
+// which is how placements only reachable by soft drops, tucks and spins are
+// played (see movegen.h).
+//
+// When the game has a hold slot, hold says the move is for the held piece,
+// and the current piece takes its place in the slot.
 struct DropMove {
-  int col, rot;
+  int col, rot, row;
+  bool hold;
 
-  DropMove(int col, int rot): col(col), rot(rot) {}
+  DropMove(int col, int rot): col(col), rot(rot), row(-1), hold(false) {}
+  DropMove(int col, int rot, int row): col(col), rot(rot), row(row), hold(false) {}
 
   static DropMove invalid() {
     return DropMove(-1, -1);
@@ -68,15 +114,23 @@ struct DropMove {
   bool valid() const {
     return col >= 0;
   }
+
+  bool operator==(const DropMove &m) const {
+    return col == m.col && rot == m.rot && row == m.row && hold == m.hold;
+  }
+  bool operator!=(const DropMove &m) const { return !(*this == m); }
 };
 
 struct Move {
   PieceType piece;
   int row, col, rot, linesCleared, pieceHeight;
 
-  Move(): piece(PieceType::I), row(-1), col(-1), rot(-1), linesCleared(0) {}
-  Move(PieceType piece, int row, int col, int rot, int linesCleared)
-    : piece(piece), row(row), col(col), rot(rot), linesCleared(linesCleared) {}
+  // Cells of the piece itself that were removed by the lines it cleared.
+  int erodedCells;
+
+  Move(): piece(PieceType::I), row(-1), col(-1), rot(-1), linesCleared(0), erodedCells(0) {}
+  Move(PieceType piece, int row, int col, int rot, int linesCleared, int erodedCells = 0)
+    : piece(piece), row(row), col(col), rot(rot), linesCleared(linesCleared), erodedCells(erodedCells) {}
 
   static Move invalid() {
     return Move(PieceType::I, -1, -1, -1, 0);
@@ -87,74 +141,345 @@ struct Move {
   }
 };
 
-class Board {
+// Smallest unsigned word that holds a row of the given width.
+template <int W>
+using BoardRow =
+  std::conditional_t<(W <= 16), uint16_t,
+  std::conditional_t<(W <= 32), uint32_t,
+  uint64_t>>;
+
+// Column words are stored bottom-up: bit 0 is the bottom row, so the height
+// of a column is its bit length. There is always at least one spare bit on
+// top, so masks up to the column height can be built with a shift.
+template <int H>
+using BoardColumn = std::conditional_t<(H < 32), uint32_t, uint64_t>;
+
+template <typename T>
+constexpr int bitCount(T x) {
+  if constexpr (sizeof(T) <= 4) return __builtin_popcount(x);
+  return __builtin_popcountll(x);
+}
+
+template <typename T>
+constexpr int lowestBit(T x) {
+  if constexpr (sizeof(T) <= 4) return __builtin_ctz(x);
+  return __builtin_ctzll(x);
+}
+
+template <typename T>
+constexpr int bitLength(T x) {
+  if (x == 0) return 0;
+  if constexpr (sizeof(T) <= 4) return 32-__builtin_clz(x);
+  return 64-__builtin_clzll(x);
+}
+
+// Board dimensions are template parameters so that every loop over rows and
+// columns has a compile-time bound. Row 0 is the top of the board, and bit j
+// of a row is column j.
+//
+// With Columns set, the board also keeps a transposed copy (one word per
+// column) up to date on placement and line clear, so that column features can
+// be computed with a few bit operations per column. Debug builds check it
+// against the rows after every move.
+template <int W, int H, bool Columns = false>
+class BasicBoard {
+  static_assert(W >= 4 && W <= 64, "board width must be between 4 and 64");
+  static_assert(H >= 4, "board height must be at least 4");
+  static_assert(H < 64, "board height must be less than 64");
+
+public:
+  using Row = BoardRow<W>;
+  using Column = BoardColumn<H>;
+
+  static constexpr bool hasColumns = Columns;
+  static constexpr Row fullRow = Row(~Row(0)) >> (8*sizeof(Row) - W);
+  static constexpr Column fullColumn = Column(~Column(0)) >> (8*sizeof(Column) - H);
+
 private:
-  std::array<uint16_t, 20> array, arrayCopy;
-  int _width, _height;
+  std::array<Row, H> array;
+  std::array<Column, Columns ? W : 0> columns;
   int lastEmptyRow;
 
-  int getDropRow(PieceType piece, DropMove move) const;
   int dropPiece(PieceType piece, DropMove move);
-  int clearLines();
+  int clearLines(int dropRow, int pieceHeight);
 
 public:
-  Board(): array({}), _width(10), _height(20), lastEmptyRow(19) {}
-  Board(const Board &b) = default;
-  Board(Board &&b) = default;
+  BasicBoard(): array({}), columns({}), lastEmptyRow(H-1) {}
+  BasicBoard(const BasicBoard &b) = default;
+  BasicBoard(BasicBoard &&b) = default;
+  BasicBoard &operator=(const BasicBoard &b) = default;
+
+  // Rows must not contain full lines, and must not have empty rows below
+  // filled ones, as on any board reached by playing moves.
+  explicit BasicBoard(const std::array<Row, H> &rows);
+
+  // Whether rows meet the constructor's requirements and have no cells
+  // outside the board, for rows that come from outside the program.
+  static bool validRows(const std::array<Row, H> &rows) {
+    bool filled = false;
+    for (auto r : rows) {
+      if ((r & ~fullRow) != 0 || r == fullRow || (filled && r == 0)) return false;
+      filled = filled || r != 0;
+    }
+    return true;
+  }
 
-  inline int width() const { return _width; }
-  inline int height() const { return _height; }
+  static constexpr int width() { return W; }
+  static constexpr int height() { return H; }
 
   inline const int cell(int row, int col) const {
     return (array[row] >> col) & 1;
   }
 
-  inline uint16_t row(int i) const { return array[i]; }
+  inline Row row(int i) const { return array[i]; }
+  inline const std::array<Row, H> &rows() const { return array; }
+
+  // Number of non-empty rows.
+  inline int stackHeight() const { return H-1-lastEmptyRow; }
+
+  // Only available when Columns is set. Bit i is row H-1-i.
+  inline Column column(int j) const { return columns[j]; }
+
+  bool columnsConsistent() const;
+
+  // Whether the piece fits with its top-left corner at the given cell.
+  bool fits(PieceType piece, int rot, int row, int col) const;
+
+  // Row the top of the piece comes to rest at, or -1 if it does not fit.
+  int getDropRow(PieceType piece, DropMove move) const;
 
   Move playMove(PieceType piece, DropMove move);
-  void print();
+
+  // Pushes the stack up by count rows and fills them with garbage: full rows
+  // but for a hole at column hole. Returns false, leaving the board as it
+  // was, if the stack would be pushed out of the top.
+  bool insertGarbage(int count, int hole);
+
+  void print() const;
+
+  bool operator==(const BasicBoard &b) const { return array == b.array; }
+  bool operator!=(const BasicBoard &b) const { return array != b.array; }
 };
 
-void enumerateMoves(
-    const Board &board,
-    PieceType pieceType,
-    std::function<void(DropMove)>);
+using Board = BasicBoard<10, 20>;
 
+// Taller variants used for experiments: 4 hidden spawn rows above the usual
+// 20, and the 40 row buffer used by guideline games.
+using SpawnBoard = BasicBoard<10, 24>;
+using TallBoard = BasicBoard<10, 40>;
 
-// Function signature for AI to implement.
-// Given current state of the board, and a piece to place, return the move to play.
-// DropMove is just a tuple of column and rotation.
-using PlayerFunc = std::function<DropMove(const Board &, PieceType)>;
+using ColumnBoard = BasicBoard<10, 20, true>;
+using SpawnColumnBoard = BasicBoard<10, 24, true>;
+using TallColumnBoard = BasicBoard<10, 40, true>;
 
-struct GameStats {
-  int pieces;
-  int linesCleared;
-  std::map<PieceType, int> pieceFrequency;
+// Calls X(B) for every board type above. The AIs defined out of line are
+// explicitly instantiated from this list, so adding a board here makes it
+// usable with all of them.
+#define FOR_EACH_BOARD(X) \
+  X(Board) X(SpawnBoard) X(TallBoard) \
+  X(ColumnBoard) X(SpawnColumnBoard) X(TallColumnBoard)
 
-  GameStats(): pieces(0), linesCleared(0) {}
-};
+template <int W, int H, bool Columns>
+BasicBoard<W, H, Columns>::BasicBoard(const std::array<Row, H> &rows)
+  : array(rows), columns({}), lastEmptyRow(H-1) {
 
-// Game is deterministic state machine.
-// Given the same seed and randomizer, it should always produce the same sequence of pieces.
-class Game {
-private:
-  std::default_random_engine rng;
-  int seed;
-  Board board;
-  Move lastMove;
-  GameStats _stats;
-  PieceGenerator nextPiece;
+  while (lastEmptyRow >= 0 && array[lastEmptyRow] > 0) lastEmptyRow--;
 
-public:
-  enum TickResult { Ok, GameOver };
+  if constexpr (Columns) {
+    for (int i = lastEmptyRow+1; i < H; i++) {
+      for (auto bits = array[i]; bits != 0; bits &= bits-1) {
+        columns[lowestBit(bits)] |= Column(1) << (H-1-i);
+      }
+    }
+  }
+}
+
+template <int W, int H, bool Columns>
+bool BasicBoard<W, H, Columns>::fits(PieceType pieceType, int rot, int row, int col) const {
+  const auto &piece = pieceShape(pieceType, rot);
+  if (row < 0 || row+piece.height > H || col < 0 || col+piece.width > W) return false;
+
+  for (int i = 0; i < piece.height; i++) {
+    if ((array[row + i] & (Row(piece.rows[i]) << col)) != 0) return false;
+  }
+  return true;
+}
+
+template <int W, int H, bool Columns>
+int BasicBoard<W, H, Columns>::getDropRow(PieceType pieceType, DropMove move) const {
+  const auto &piece = pieceShape(pieceType, move.rot);
+
+  // The piece has to fit there and rest on something.
+  if (move.row >= 0) {
+    if (!fits(pieceType, move.rot, move.row, move.col)) return -1;
+    if (move.row+piece.height < H && fits(pieceType, move.rot, move.row+1, move.col)) return -1;
+    return move.row;
+  }
+
+  int startRow = lastEmptyRow-piece.height+1 >= 0 ? lastEmptyRow-piece.height+1 : 0;
 
-  Game(int seed, PieceRandomizer randomizer):
-    rng(std::default_random_engine(seed)), seed(seed), nextPiece(randomizer(seed)) {}
+  for (int row = startRow; row < H-piece.height+1; row++) {
+    for (int i = 0; i < piece.height; i++) {
+      if ((array[row + i] & (Row(piece.rows[i]) << move.col)) != 0) return row-1;
+    }
+  }
+  return H-piece.height;
+}
+
+template <int W, int H, bool Columns>
+int BasicBoard<W, H, Columns>::dropPiece(PieceType pieceType, DropMove move) {
+  auto dropRow = getDropRow(pieceType, move);
+  if (dropRow < 0) return -1;
+
+  const auto &piece = pieceShape(pieceType, move.rot);
+
+  for (int i = 0; i < piece.height; i++) {
+    array[dropRow + i] |= (Row(piece.rows[i]) << move.col);
+  }
 
-  const GameStats &stats() const { return _stats; }
+  if constexpr (Columns) {
+    for (int i = 0; i < piece.height; i++) {
+      auto bit = Column(1) << (H-1-dropRow-i);
+      for (uint16_t bits = piece.rows[i]; bits != 0; bits &= bits-1) {
+        columns[move.col + __builtin_ctz(bits)] |= bit;
+      }
+    }
+  }
+
+  return dropRow;
+}
+
+template <int W, int H, bool Columns>
+int BasicBoard<W, H, Columns>::clearLines(int dropRow, int pieceHeight) {
+  if (dropRow <= lastEmptyRow) lastEmptyRow = dropRow-1;
+
+  // Only the rows the piece landed in can have become full.
+  int bottom = dropRow+pieceHeight-1;
+  int linesCleared = 0;
+  for (int i = dropRow; i <= bottom; i++) {
+    if (array[i] == fullRow) linesCleared++;
+  }
+  if (linesCleared == 0) return 0;
+
+  // Compact the piece's rows in place, bottom up.
+  int removed = 0;
+  int current = bottom;
+  for (int i = bottom; i >= dropRow; i--) {
+    if (array[i] == fullRow) {
+      if constexpr (Columns) {
+        // Rows below have already been removed and shifted everything above
+        // them down, so this row now sits removed bits lower.
+        int bit = H-1-i-removed;
+        Column below = (Column(1) << bit)-1;
+        for (auto &c : columns) c = (c & below) | ((c >> 1) & ~below);
+      }
+
+      removed++;
+      continue;
+    }
+
+    array[current--] = array[i];
+  }
+
+  // Then shift the stack above them down in one go.
+  int top = lastEmptyRow+1;
+  std::memmove(&array[top+linesCleared], &array[top], (dropRow-top)*sizeof(Row));
+  std::fill(&array[top], &array[top+linesCleared], 0);
+
+  lastEmptyRow += linesCleared;
+
+  return linesCleared;
+}
+
+template <int W, int H, bool Columns>
+Move BasicBoard<W, H, Columns>::playMove(PieceType pieceType, DropMove move) {
+  if (!move.valid() || move.rot < 0 || move.rot >= pieceRotations(pieceType)) return Move::invalid();
+
+  const auto &piece = pieceShape(pieceType, move.rot);
+  if (move.col + piece.width > W) return Move::invalid();
+
+  auto dropRow = dropPiece(pieceType, move);
+  if (dropRow < 0) return Move::invalid();
+
+  int erodedCells = 0;
+  for (int i = 0; i < piece.height; i++) {
+    if (array[dropRow+i] == fullRow) erodedCells += bitCount(piece.rows[i]);
+  }
 
-  TickResult tick(PlayerFunc player);
-  void print();
+  auto linesCleared = clearLines(dropRow, piece.height);
+
+  if constexpr (Columns) assert(columnsConsistent());
+
+  return Move(pieceType, dropRow, move.col, move.rot, linesCleared, erodedCells);
+}
+
+template <int W, int H, bool Columns>
+bool BasicBoard<W, H, Columns>::insertGarbage(int count, int hole) {
+  assert(hole >= 0 && hole < W);
+  if (count <= 0) return true;
+  if (stackHeight()+count > H) return false;
+
+  int top = lastEmptyRow+1;
+  std::memmove(&array[top-count], &array[top], (H-top)*sizeof(Row));
+  std::fill(&array[H-count], &array[H], Row(fullRow & ~(Row(1) << hole)));
+  lastEmptyRow -= count;
+
+  if constexpr (Columns) {
+    Column garbage = (Column(1) << count)-1;
+    for (int j = 0; j < W; j++) columns[j] = (columns[j] << count) | (j != hole ? garbage : 0);
+    assert(columnsConsistent());
+  }
+
+  return true;
+}
+
+template <int W, int H, bool Columns>
+bool BasicBoard<W, H, Columns>::columnsConsistent() const {
+  if constexpr (Columns) {
+    for (int j = 0; j < W; j++) {
+      Column expected = 0;
+      for (int i = 0; i < H; i++) {
+        expected |= Column(cell(i, j)) << (H-1-i);
+      }
+      if (columns[j] != expected) return false;
+    }
+  }
+  return true;
+}
+
+template <int W, int H, bool Columns>
+void BasicBoard<W, H, Columns>::print() const {
+  for (int i = 0; i < H; i++) {
+    for (int j = 0; j < W; j++) {
+      auto c = cell(i, j);
+      std::cout << (c == 1 ? 'O' : '.');
+    }
+    std::cout << std::endl;
+  }
+}
+
+template <typename B, typename Fn>
+void enumerateMoves(const B &board, PieceType piece, Fn &&fn) {
+  for (int rot = 0; rot < pieceRotations(piece); rot++) {
+    for (int col = 0; col < B::width()-pieceShape(piece, rot).width+1; col++) {
+      fn(DropMove(col, rot));
+    }
+  }
+}
+
+// Pieces coming after the current one, next first, for games with a preview.
+struct PiecePreview {
+  static constexpr int capacity = 16;
+
+  std::array<PieceType, capacity> pieces;
+  int count = 0;
+
+  PieceType operator[](int i) const { return pieces[i]; }
 };
 
+// Function signature for AI to implement.
+// Given current state of the board, and a piece to place, return the move to play.
+// DropMove is just a tuple of column and rotation.
+using PlayerFunc = std::function<DropMove(const Board &, PieceType)>;
+
 #endif
@@ -0,0 +1,104 @@
+#include "tetrisai.h"
+#include "eltetris.h"
+#include "yiyuan.h"
+#include "dellacherie.h"
+#include "bcts.h"
+
+#include <algorithm>
+#include <new>
+#include <tuple>
+
+static_assert(Board::width() == TETRISAI_WIDTH && Board::height() == TETRISAI_HEIGHT,
+              "the C interface is for the standard board");
+
+// Everything a query needs is built by tetrisai_create: the evaluator with
+// its weights, and the move set. A query copies the rows into a Board on the
+// stack and scores the candidates against it, exactly as greedyMove does.
+struct tetrisai {
+  virtual ~tetrisai() = default;
+  virtual int query(const uint16_t *rows, int piece, tetrisai_move *move) const = 0;
+};
+
+namespace {
+
+template <typename E>
+class EvaluatorEngine : public tetrisai {
+private:
+  E evaluator;
+  MoveSet moves;
+
+public:
+  EvaluatorEngine(const E &evaluator, const double *weights, MoveSet moves):
+    evaluator(evaluator), moves(moves) {
+
+    if (weights == nullptr) return;
+    std::apply([&](auto &...terms) {
+      int i = 0;
+      ((terms.weight = weights[i++]), ...);
+    }, this->evaluator.terms);
+  }
+
+  int query(const uint16_t *rows, int piece, tetrisai_move *move) const override {
+    *move = { -1, -1, -1, 0.0 };
+    if (piece < I || piece > Z) return -1;
+
+    std::array<Board::Row, Board::height()> array;
+    std::copy(rows, rows + Board::height(), array.begin());
+    if (!Board::validRows(array)) return -1;
+
+    Board board(array);
+    IncrementalEvaluator<E, Board> candidates(evaluator, board);
+    auto best = bestMove(candidates, PieceType(piece), moves);
+    if (!best.first.valid()) return 0;
+
+    *move = { best.first.col, best.first.rot, board.getDropRow(PieceType(piece), best.first), best.second };
+    return 1;
+  }
+};
+
+template <typename E>
+tetrisai *makeEngine(const E &evaluator, const double *weights, MoveSet moves) {
+  return new (std::nothrow) EvaluatorEngine<E>(evaluator, weights, moves);
+}
+
+}
+
+int tetrisai_weight_count(int ai) {
+  switch (ai) {
+    case TETRISAI_ELTETRIS: return decltype(elTetrisEvaluator)::size;
+    case TETRISAI_YIYUAN: return decltype(yiyuanEvaluator)::size;
+    case TETRISAI_DELLACHERIE: return decltype(dellacherieEvaluator)::size;
+    case TETRISAI_BCTS: return decltype(bctsEvaluator)::size;
+    default: return -1;
+  }
+}
+
+tetrisai *tetrisai_create(int ai, const double *weights, int moves) {
+  if (moves != TETRISAI_HARD_DROPS && moves != TETRISAI_REACHABLE) return nullptr;
+  auto set = moves == TETRISAI_REACHABLE ? MoveSet::Reachable : MoveSet::HardDrops;
+
+  switch (ai) {
+    case TETRISAI_ELTETRIS: return makeEngine(elTetrisEvaluator, weights, set);
+    case TETRISAI_YIYUAN: return makeEngine(yiyuanEvaluator, weights, set);
+    case TETRISAI_DELLACHERIE: return makeEngine(dellacherieEvaluator, weights, set);
+    case TETRISAI_BCTS: return makeEngine(bctsEvaluator, weights, set);
+    default: return nullptr;
+  }
+}
+
+void tetrisai_destroy(tetrisai *engine) {
+  delete engine;
+}
+
+int tetrisai_query(const tetrisai *engine, const uint16_t rows[TETRISAI_HEIGHT], int piece, tetrisai_move *move) {
+  return engine->query(rows, piece, move);
+}
+
+size_t tetrisai_query_batch(const tetrisai *engine, const uint16_t *rows, const uint8_t *pieces,
+                            size_t count, tetrisai_move *moves) {
+  size_t placed = 0;
+  for (size_t k = 0; k < count; k++) {
+    placed += engine->query(rows + k*TETRISAI_HEIGHT, pieces[k], &moves[k]) == 1;
+  }
+  return placed;
+}
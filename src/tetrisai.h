@@ -0,0 +1,84 @@
+#ifndef _TETRISAI_H_
+#define _TETRISAI_H_
+
+// C interface to the one-piece AIs, built by `make lib` as bin/libtetrisai.a
+// and bin/libtetrisai.so. Link the static library with -lstdc++ -pthread.
+//
+// Boards are 10 wide and 20 tall, given as 20 rows from the top down, with
+// bit 0 of a row the leftmost cell. An engine only reads its handle, so one
+// handle can be shared between threads, and queries do not allocate.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define TETRISAI_API __attribute__((visibility("default")))
+#else
+#define TETRISAI_API
+#endif
+
+#define TETRISAI_WIDTH 10
+#define TETRISAI_HEIGHT 20
+
+// AIs, with the features and weights of the matching -a option.
+enum {
+  TETRISAI_ELTETRIS = 0,
+  TETRISAI_YIYUAN,
+  TETRISAI_DELLACHERIE,
+  TETRISAI_BCTS,
+};
+
+// Pieces, in the order of PieceType.
+enum {
+  TETRISAI_I = 0,
+  TETRISAI_O, TETRISAI_T,
+  TETRISAI_L, TETRISAI_J,
+  TETRISAI_S, TETRISAI_Z,
+};
+
+// Placements considered, as for -M.
+enum {
+  TETRISAI_HARD_DROPS = 0,
+  TETRISAI_REACHABLE,
+};
+
+typedef struct tetrisai tetrisai;
+
+// A placement: the leftmost column and rotation of the piece, and the row
+// its top lands on, or -1 in all three if the piece cannot be placed.
+typedef struct {
+  int col, rot, row;
+  double score;
+} tetrisai_move;
+
+// Number of weights the AI takes, or -1 if there is no such AI.
+TETRISAI_API int tetrisai_weight_count(int ai);
+
+// Creates an engine, or returns NULL if ai or moves is unknown. weights has
+// tetrisai_weight_count(ai) entries in the order the AI declares its
+// features, or is NULL for the AI's own weights.
+TETRISAI_API tetrisai *tetrisai_create(int ai, const double *weights, int moves);
+TETRISAI_API void tetrisai_destroy(tetrisai *engine);
+
+// Best placement of piece on the board. Returns 1 if there is one, 0 if the
+// piece cannot be placed, or -1 if piece is unknown or the rows are not a
+// board: a row has cells outside the board or is full, or an empty row is
+// under a filled one.
+TETRISAI_API int tetrisai_query(const tetrisai *engine, const uint16_t rows[TETRISAI_HEIGHT],
+                                int piece, tetrisai_move *move);
+
+// tetrisai_query for count boards, stored one after another in rows, with
+// one piece each. Returns how many could be placed; boards that could not,
+// including invalid ones, get a move of -1s.
+TETRISAI_API size_t tetrisai_query_batch(const tetrisai *engine, const uint16_t *rows,
+                                         const uint8_t *pieces, size_t count, tetrisai_move *moves);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
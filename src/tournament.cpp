@@ -0,0 +1,170 @@
+#include "tournament.h"
+#include "parallel.h"
+#include "stats.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+// Regularized incomplete beta function I_x(a, b), by its continued fraction.
+double incompleteBeta(double x, double a, double b) {
+  if (x <= 0) return 0;
+  if (x >= 1) return 1;
+  if (x > (a + 1) / (a + b + 2)) return 1 - incompleteBeta(1 - x, b, a);
+
+  double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b)
+                          + a * std::log(x) + b * std::log(1 - x)) / a;
+  double tiny = 1e-300;
+  double c = 1, d = 1 - (a + b) * x / (a + 1);
+  d = 1 / (std::abs(d) < tiny ? tiny : d);
+  double f = d;
+  for (int m = 1; m < 300; m++) {
+    for (int odd = 0; odd < 2; odd++) {
+      double num = odd ? -(a + m) * (a + b + m) * x / ((a + 2*m) * (a + 2*m + 1))
+                       : m * (b - m) * x / ((a + 2*m - 1) * (a + 2*m));
+      d = 1 + num * d;
+      d = 1 / (std::abs(d) < tiny ? tiny : d);
+      c = 1 + num / c;
+      if (std::abs(c) < tiny) c = tiny;
+      f *= c * d;
+    }
+    if (std::abs(c * d - 1) < 1e-15) break;
+  }
+  return front * f;
+}
+
+// P(T < x) for Student's t with df degrees of freedom.
+double studentCdf(double x, double df) {
+  double tail = incompleteBeta(df / (df + x * x), df / 2, 0.5) / 2;
+  return x < 0 ? tail : 1 - tail;
+}
+
+// x such that P(T < x) = p for Student's t with df degrees of freedom.
+double studentQuantile(double p, double df) {
+  double low = 0, high = 1;
+  while (studentCdf(high, df) < p) high *= 2;
+  for (int i = 0; i < 100; i++) {
+    double mid = (low + high) / 2;
+    if (studentCdf(mid, df) < p) low = mid;
+    else high = mid;
+  }
+  return (low + high) / 2;
+}
+
+template <typename Fn>
+PairedDifference difference(const std::vector<TournamentGame> &games, double level, Fn fn) {
+  PairedDifference d;
+  RunningStats stats;
+  for (const auto &game : games) {
+    int x = fn(game);
+    stats.add(x);
+    if (x > 0) d.wins++;
+    else if (x < 0) d.losses++;
+    else d.ties++;
+  }
+
+  d.mean = stats.mean();
+  d.stddev = stats.stddev();
+  long n = stats.count();
+  double margin = n > 1 ? studentQuantile(1 - level / 2, n - 1) * d.stddev / std::sqrt(double(n)) : 0;
+  d.low = d.mean - margin;
+  d.high = d.mean + margin;
+  return d;
+}
+
+}
+
+
+TournamentResult runTournament(const TournamentPlayer &a, const TournamentPlayer &b,
+                               int seed, int maxGames, double confidence, int threads) {
+  std::vector<int> looks;
+  for (int n = 16; n < maxGames; n *= 2) looks.push_back(n);
+  looks.push_back(maxGames);
+
+  double level = (1 - confidence) / looks.size();
+
+  TournamentResult result;
+  for (int look : looks) {
+    int played = result.games.size();
+    int count = look - played;
+
+    // Each side of each pairing is a task of its own, so a long game of one
+    // AI does not hold up the other's.
+    std::vector<GameStats> stats(2*count);
+    parallelFor(2*count, threads, [&](int i, int) {
+      stats[i] = (i % 2 == 0 ? a : b)(seed + played + i/2);
+    });
+
+    for (int i = 0; i < count; i++) {
+      const auto &sa = stats[2*i], &sb = stats[2*i+1];
+      result.games.push_back({ seed + played + i, sa.linesCleared, sb.linesCleared, sa.pieces, sb.pieces });
+      result.a.add(sa);
+      result.b.add(sb);
+    }
+
+    result.looks++;
+    result.lines = difference(result.games, level, [](const TournamentGame &g) { return g.linesA - g.linesB; });
+    result.pieces = difference(result.games, level, [](const TournamentGame &g) { return g.piecesA - g.piecesB; });
+
+    result.decided = result.games.size() > 1 && (result.lines.low > 0 || result.lines.high < 0);
+    if (result.decided) break;
+  }
+
+  return result;
+}
+
+bool reportTournament(const TournamentResult &result, const std::string &nameA, const std::string &nameB,
+                      double confidence, const std::string &csv) {
+  auto printDifference = [](const char *name, const PairedDifference &d) {
+    std::cout << name << "_diff=" << d.mean << ", stddev=" << d.stddev
+      << ", interval=[" << d.low << "," << d.high << "]"
+      << ", wins=" << d.wins << ", losses=" << d.losses << ", ties=" << d.ties << std::endl;
+  };
+
+  std::cout << "games=" << result.games.size() << ", looks=" << result.looks << std::endl;
+  for (auto [name, summary] : { std::make_pair(nameA, &result.a), std::make_pair(nameB, &result.b) }) {
+    std::cout << name << ": lines=" << summary->lines.stats.mean() << ", lines_p50=" << summary->lines.quantiles.quantile(0.5)
+      << ", pieces=" << summary->pieces.stats.mean() << std::endl;
+  }
+  printDifference("lines", result.lines);
+  printDifference("pieces", result.pieces);
+
+  if (result.decided) {
+    std::cout << "result=" << (result.lines.mean > 0 ? nameA : nameB) << " clears more lines";
+  } else {
+    std::cout << "result=no difference in lines cleared found";
+  }
+  std::cout << " at confidence " << confidence << std::endl;
+
+  if (csv.empty()) return true;
+
+  std::ofstream out(csv);
+  out << "seed,lines_a,lines_b,pieces_a,pieces_b\n";
+  for (const auto &game : result.games) {
+    out << game.seed << "," << game.linesA << "," << game.linesB << ","
+      << game.piecesA << "," << game.piecesB << "\n";
+  }
+  return bool(out);
+}
+
+GameSummary runSweep(const TournamentPlayer &play, int seed, int games, int threads) {
+  std::vector<GameSummary> summaries(defaultThreads(threads));
+  parallelFor(games, threads, [&](int i, int thread) {
+    summaries[thread].add(play(seed + i));
+  });
+
+  for (size_t t = 1; t < summaries.size(); t++) summaries[0].merge(summaries[t]);
+  return summaries[0];
+}
+
+void reportSummary(const GameSummary &summary) {
+  for (auto [name, d] : { std::make_pair("lines", &summary.lines), std::make_pair("pieces", &summary.pieces) }) {
+    std::cout << name << ": mean=" << d->stats.mean() << ", stddev=" << d->stats.stddev()
+      << ", min=" << d->stats.min() << ", p1=" << d->quantiles.quantile(0.01)
+      << ", p50=" << d->quantiles.quantile(0.5) << ", p99=" << d->quantiles.quantile(0.99)
+      << ", max=" << d->stats.max() << std::endl;
+  }
+}
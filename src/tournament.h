@@ -0,0 +1,71 @@
+#ifndef _TOURNAMENT_H_
+#define _TOURNAMENT_H_
+
+#include "game.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Paired comparison of two AIs: both play a game on every seed, so they get
+// the same pieces for as long as both survive, and the statistic is the
+// per-seed difference A - B, whose variance is far below that of either
+// side's results.
+//
+// Games are played in rounds, on as many threads as asked, and after each
+// round a two-sided Student t-test on the mean difference in lines cleared
+// decides whether to stop, which keeps its level on the few games of an
+// early look as long as the differences are close to normal. Rounds end at
+// 16, 32, 64, ... games and at the maximum, and each test is run at level
+// (1 - confidence) / looks, looks being the number of rounds the maximum
+// allows, so the chance of a wrong call over the whole tournament stays
+// within 1 - confidence however early it stops.
+
+// Plays one game on the given seed and returns its stats. Called from
+// several threads at once.
+using TournamentPlayer = std::function<GameStats(int seed)>;
+
+struct TournamentGame {
+  int seed;
+  int linesA, linesB;
+  int piecesA, piecesB;
+};
+
+struct PairedDifference {
+  double mean = 0;
+  double stddev = 0;
+  // Confidence interval for the mean at the level of the last test.
+  double low = 0, high = 0;
+  int wins = 0, losses = 0, ties = 0;
+};
+
+struct TournamentResult {
+  std::vector<TournamentGame> games;
+  GameSummary a, b;
+  PairedDifference lines, pieces;
+  int looks = 0;
+  // Whether the test on lines cleared was significant, in which case the
+  // tournament stopped there.
+  bool decided = false;
+};
+
+// Plays games on seeds seed, seed+1, ... until the test decides or maxGames
+// have been played.
+TournamentResult runTournament(const TournamentPlayer &a, const TournamentPlayer &b,
+                               int seed, int maxGames, double confidence, int threads);
+
+// Prints a summary with A and B named nameA and nameB, and if csv is not
+// empty, writes one line per seed to it. Returns false if csv could not be
+// written.
+bool reportTournament(const TournamentResult &result, const std::string &nameA, const std::string &nameB,
+                      double confidence, const std::string &csv);
+
+// Plays games games on seeds seed, seed+1, ... on the given threads, each
+// thread adding its games to a GameSummary of its own, and merges them.
+GameSummary runSweep(const TournamentPlayer &play, int seed, int games, int threads);
+
+// Prints a line of mean, standard deviation, range and quantiles for each
+// distribution in summary.
+void reportSummary(const GameSummary &summary);
+
+#endif
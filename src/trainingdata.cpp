@@ -0,0 +1,158 @@
+#include "trainingdata.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool writeAll(int fd, const void *data, size_t size) {
+  auto bytes = static_cast<const char *>(data);
+  for (size_t done = 0; done < size; ) {
+    ssize_t n = ::write(fd, bytes+done, size-done);
+    if (n <= 0) return false;
+    done += n;
+  }
+  return true;
+}
+
+TrainingWriter::TrainingWriter(const std::string &path, int height, int horizon, bool background):
+  background(background) {
+
+  // Sized before the file is opened, so that records can still be written
+  // (and dropped) when it could not be.
+  for (auto &buffer : buffers) buffer.resize(bufferRecords);
+
+  fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    failed = true;
+    return;
+  }
+
+  TrainingFileHeader header {};
+  memcpy(header.magic, TrainingFileHeader::expectedMagic, sizeof(header.magic));
+  header.version = TrainingFileHeader::currentVersion;
+  header.recordSize = sizeof(TrainingRecord);
+  header.features = trainingFeatureCount;
+  header.height = height;
+  header.horizon = horizon;
+  failed = !writeAll(fd, &header, sizeof(header));
+
+  if (background) thread = std::thread(&TrainingWriter::work, this);
+}
+
+TrainingWriter::~TrainingWriter() {
+  close();
+}
+
+void TrainingWriter::writeBuffer(int buffer, size_t count) {
+  if (!failed && !writeAll(fd, buffers[buffer].data(), count*sizeof(TrainingRecord))) failed = true;
+}
+
+// Only the writer thread touches the file while a buffer is pending.
+void TrainingWriter::work() {
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    changed.wait(lock, [&] { return stopping || pending > 0; });
+    if (pending == 0) return;
+
+    int buffer = pendingBuffer;
+    size_t count = pending;
+    lock.unlock();
+    writeBuffer(buffer, count);
+    lock.lock();
+
+    pending = 0;
+    changed.notify_all();
+  }
+}
+
+void TrainingWriter::submit() {
+  if (!background) {
+    writeBuffer(current, used);
+    used = 0;
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  if (pending > 0) {
+    stalls++;
+    changed.wait(lock, [&] { return pending == 0; });
+  }
+
+  pendingBuffer = current;
+  pending = used;
+  current ^= 1;
+  used = 0;
+  changed.notify_all();
+}
+
+bool TrainingWriter::close() {
+  if (fd < 0) return !failed;
+
+  if (used > 0) submit();
+  if (background) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    changed.notify_all();
+    thread.join();
+  }
+
+  if (::close(fd) != 0) failed = true;
+  fd = -1;
+  return !failed;
+}
+
+void TrainingRecorder::emit(long k, long piecesLeft, bool died) {
+  auto &record = waiting[k % horizon];
+  record.died = died;
+  record.piecesLeft = piecesLeft;
+  record.futureLines = lines - linesThrough[k % horizon];
+  writer.write(record);
+}
+
+void TrainingRecorder::endGame(bool died) {
+  for (long k = first; k < count; k++) emit(k, count-1-k, died);
+
+  first = count = 0;
+  lines = 0;
+  game++;
+}
+
+TrainingReader::TrainingReader(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TrainingFileHeader)) {
+    ::close(fd);
+    return;
+  }
+
+  void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) return;
+
+  memcpy(&header, mapped, sizeof(header));
+  size_t body = info.st_size - sizeof(header);
+  if (memcmp(header.magic, TrainingFileHeader::expectedMagic, sizeof(header.magic)) != 0 ||
+      header.version != TrainingFileHeader::currentVersion ||
+      header.recordSize != sizeof(TrainingRecord) || header.features != trainingFeatureCount ||
+      body % sizeof(TrainingRecord) != 0) {
+    munmap(mapped, info.st_size);
+    return;
+  }
+
+  madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+  mapping = mapped;
+  length = info.st_size;
+  records = reinterpret_cast<const TrainingRecord *>(static_cast<const char *>(mapped) + sizeof(header));
+  count = body / sizeof(TrainingRecord);
+}
+
+TrainingReader::~TrainingReader() {
+  if (mapping != nullptr) munmap(mapping, length);
+}
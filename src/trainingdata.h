@@ -0,0 +1,224 @@
+#ifndef _TRAININGDATA_H_
+#define _TRAININGDATA_H_
+
+#include "tetris.h"
+#include "evaluator.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Training data for learned evaluators: one TrainingRecord per piece played,
+// with the board it was played on, the move, the features of the afterstate
+// and what became of the game afterwards.
+//
+// A file is a TrainingFileHeader followed by records, in native byte order,
+// so TrainingReader can hand out records straight from a mapping of the file.
+// Rows of boards shorter than maxTrainingHeight are stored at the end of
+// rows, leaving the rows above zero, which compresses well.
+
+// Features of the afterstate stored in every record, in this order. The
+// weights are unused.
+constexpr auto trainingFeatures = makeEvaluator(
+  weighted<LinesCleared>(0),
+  weighted<LandingHeight>(0),
+  weighted<ErodedPieceCells>(0),
+  weighted<RowTransitions>(0),
+  weighted<ColTransitions>(0),
+  weighted<Holes>(0),
+  weighted<WellSums>(0),
+  weighted<AggregateHeight>(0),
+  weighted<Bumpiness>(0),
+  weighted<HoleDepth>(0),
+  weighted<RowsWithHoles>(0));
+
+constexpr int trainingFeatureCount = decltype(trainingFeatures)::size;
+constexpr int maxTrainingHeight = TallBoard::height();
+
+struct TrainingRecord {
+  // The board before the move, top row first, bit 0 the leftmost cell.
+  uint16_t rows[maxTrainingHeight];
+
+  // Game number within the file, and piece number within the game.
+  uint32_t game;
+  uint32_t index;
+
+  // The piece played (the held one if the move swapped it in), and the
+  // move, with row where the top of the piece landed.
+  uint8_t piece;
+  int8_t col, rot, row;
+  uint8_t hold;
+  uint8_t linesCleared;
+
+  // Outcome labels. died is set if the game ended within the horizon, in
+  // which case piecesLeft is the number of pieces played after this one.
+  // Otherwise piecesLeft is the horizon, or fewer if the run was stopped
+  // before the game ended. futureLines counts the lines cleared by those
+  // pieces.
+  uint8_t died;
+  uint8_t reserved;
+  uint32_t piecesLeft;
+  uint32_t futureLines;
+
+  float features[trainingFeatureCount];
+};
+
+static_assert(sizeof(TrainingRecord) == 148, "TrainingRecord is a file format");
+
+struct TrainingFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint32_t features;
+  uint32_t height;
+  uint32_t horizon;
+  uint32_t reserved;
+
+  static constexpr char expectedMagic[8] = "TTRAIN";
+  static constexpr uint32_t currentVersion = 1;
+};
+
+static_assert(sizeof(TrainingFileHeader) == 32, "TrainingFileHeader is a file format");
+
+// Buffers records and writes them out in large blocks. With background set,
+// a full buffer is handed to a writer thread and filling continues in a
+// second buffer, so the caller only waits if the disk falls a whole buffer
+// behind (counted in stalls).
+class TrainingWriter {
+private:
+  static constexpr size_t bufferRecords = 1 << 14;
+
+  int fd;
+  bool failed = false;
+
+  std::vector<TrainingRecord> buffers[2];
+  int current = 0;
+  size_t used = 0;
+
+  bool background;
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable changed;
+  int pendingBuffer = 0;
+  size_t pending = 0;
+  bool stopping = false;
+
+  void submit();
+  void writeBuffer(int buffer, size_t count);
+  void work();
+
+public:
+  long records = 0;
+  long stalls = 0;
+
+  TrainingWriter(const std::string &path, int height, int horizon, bool background);
+  ~TrainingWriter();
+
+  TrainingWriter(const TrainingWriter &) = delete;
+  TrainingWriter &operator=(const TrainingWriter &) = delete;
+
+  // False if the file could not be opened, or the header not written.
+  // Records written after that are dropped.
+  bool ok() const { return fd >= 0 && !failed; }
+
+  void write(const TrainingRecord &record) {
+    buffers[current][used++] = record;
+    records++;
+    if (used == bufferRecords) submit();
+  }
+
+  // Writes out what is buffered and closes the file. Returns false if the
+  // file could not be opened or written.
+  bool close();
+};
+
+// Builds records for the pieces of a game and holds back the last horizon of
+// them, until their outcome labels are known.
+class TrainingRecorder {
+private:
+  TrainingWriter &writer;
+  int horizon;
+
+  // Ring buffer of the records still waiting for labels, with the lines
+  // cleared in the game up to and including each one.
+  std::vector<TrainingRecord> waiting;
+  std::vector<long> linesThrough;
+  long first = 0, count = 0;
+
+  uint32_t game = 0;
+  long lines = 0;
+
+  void emit(long k, long piecesLeft, bool died);
+
+public:
+  TrainingRecorder(TrainingWriter &writer, int horizon):
+    writer(writer), horizon(horizon), waiting(horizon), linesThrough(horizon) {}
+
+  template <typename B>
+  void add(const B &before, PieceType piece, DropMove dropMove, const Move &move, const B &after);
+
+  // Labels the records still waiting and starts the next game.
+  void endGame(bool died);
+};
+
+template <typename B>
+void TrainingRecorder::add(const B &before, PieceType piece, DropMove dropMove, const Move &move, const B &after) {
+  static_assert(B::width() <= 16 && B::height() <= maxTrainingHeight, "board does not fit a TrainingRecord");
+
+  lines += move.linesCleared;
+  if (count - first == horizon) {
+    emit(first, horizon, false);
+    first++;
+  }
+
+  auto &record = waiting[count % horizon];
+  record = {};
+  for (int i = 0; i < B::height(); i++) record.rows[maxTrainingHeight-B::height()+i] = before.row(i);
+
+  record.game = game;
+  record.index = count;
+  record.piece = piece;
+  record.col = move.col;
+  record.rot = move.rot;
+  record.row = move.row;
+  record.hold = dropMove.hold;
+  record.linesCleared = move.linesCleared;
+
+  auto values = trainingFeatures.values(after, move);
+  std::copy(values.begin(), values.end(), record.features);
+
+  linesThrough[count % horizon] = lines;
+  count++;
+}
+
+// Maps a file written by TrainingWriter; records are used in place.
+class TrainingReader {
+private:
+  void *mapping = nullptr;
+  size_t length = 0;
+  const TrainingRecord *records = nullptr;
+  size_t count = 0;
+
+public:
+  TrainingFileHeader header {};
+
+  explicit TrainingReader(const std::string &path);
+  ~TrainingReader();
+
+  TrainingReader(const TrainingReader &) = delete;
+  TrainingReader &operator=(const TrainingReader &) = delete;
+
+  // False if the file could not be mapped or was not written with this
+  // record layout.
+  bool ok() const { return mapping != nullptr; }
+
+  size_t size() const { return count; }
+  const TrainingRecord &operator[](size_t i) const { return records[i]; }
+  const TrainingRecord *begin() const { return records; }
+  const TrainingRecord *end() const { return records + count; }
+};
+
+#endif
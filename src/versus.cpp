@@ -0,0 +1,35 @@
+#include "versus.h"
+
+bool receiveGarbage(Board &board, int count, GarbageHoles &holes) {
+  if (count == 0) return true;
+
+  int hole = holes.next();
+  int run = 1;
+  for (int i = 1; i <= count; i++) {
+    int next = i < count ? holes.next() : -1;
+    if (next == hole) {
+      run++;
+      continue;
+    }
+    if (!board.insertGarbage(run, hole)) return false;
+    hole = next;
+    run = 1;
+  }
+  return true;
+}
+
+void VersusSummary::add(const VersusResult &result) {
+  if (result.winner >= 0) wins[result.winner]++;
+  else draws++;
+  pieces.add(result.pieces);
+  for (int s = 0; s < 2; s++) sent[s].add(result.sent[s]);
+}
+
+void VersusSummary::merge(const VersusSummary &other) {
+  for (int s = 0; s < 2; s++) {
+    wins[s] += other.wins[s];
+    sent[s].merge(other.sent[s]);
+  }
+  draws += other.draws;
+  pieces.merge(other.pieces);
+}
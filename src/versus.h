@@ -0,0 +1,152 @@
+#ifndef _VERSUS_H_
+#define _VERSUS_H_
+
+#include "tetris.h"
+#include "parallel.h"
+#include "randomizers.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <vector>
+
+// Two-player matches: both sides get the same pieces and place one each turn,
+// and clearing lines sends garbage rows to the other side. Garbage waits
+// until its receiver places a piece that clears nothing, and is then pushed
+// in under the stack all at once. A clear first cancels garbage waiting for
+// the side that made it, and only the rest is sent. A side loses when it
+// cannot place its piece or garbage pushes its stack out of the top; if
+// both do so on the same turn, or neither has within the piece limit, the
+// match is a draw.
+//
+// Each side's garbage holes come from a random stream of its own, seeded by
+// the match: the first row's hole is at a random column, and each further
+// row moves it to a new random column with probability messiness, so 0 gives
+// one clean well per match and 1 scatters every row.
+
+struct VersusOptions {
+  // Pieces each side plays at most.
+  int pieces = 1000;
+  double messiness = 0.3;
+  // Garbage rows sent for clearing 0 to 4 lines at once.
+  int attack[5] = { 0, 0, 1, 2, 4 };
+};
+
+struct VersusResult {
+  // 0 or 1 for the side that won, -1 for a draw.
+  int winner = -1;
+  // Turns played, including the one a side lost on.
+  int pieces = 0;
+  int lines[2] = {};
+  int sent[2] = {};
+};
+
+// Hole columns for one side's garbage rows.
+class GarbageHoles {
+private:
+  StreamRandomizer stream;
+  double messiness;
+  int hole;
+
+  int column() { return ((stream.next() >> 32) * Board::width()) >> 32; }
+
+public:
+  GarbageHoles(uint64_t seed, double messiness): stream(seed), messiness(messiness) {
+    hole = column();
+  }
+
+  int next() {
+    if ((stream.next() >> 11) * 0x1p-53 < messiness) hole = column();
+    return hole;
+  }
+};
+
+// Inserts count garbage rows into board, in runs sharing a hole. Returns
+// false if the stack was pushed out of the top.
+bool receiveGarbage(Board &board, int count, GarbageHoles &holes);
+
+// Plays one match of a against b, both dealt pieces by Randomizer(seed).
+template <typename Randomizer, typename PlayerA, typename PlayerB>
+VersusResult playMatch(PlayerA &a, PlayerB &b, int seed, const VersusOptions &options) {
+  Randomizer pieces[2] = { Randomizer(seed), Randomizer(seed) };
+  GarbageHoles holes[2] = {
+    { uint64_t(seed) * 2, options.messiness },
+    { uint64_t(seed) * 2 + 1, options.messiness },
+  };
+
+  Board boards[2];
+  int pending[2] = {};
+  VersusResult result;
+
+  for (; result.pieces < options.pieces; result.pieces++) {
+    bool lost[2] = {};
+    int sent[2] = {};
+
+    for (int s = 0; s < 2; s++) {
+      auto piece = pieces[s]();
+      auto dropMove = s == 0 ? a(boards[s], piece) : b(boards[s], piece);
+      if (!dropMove.valid()) {
+        lost[s] = true;
+        continue;
+      }
+
+      auto move = boards[s].playMove(piece, dropMove);
+      if (!move.valid()) {
+        lost[s] = true;
+        continue;
+      }
+      result.lines[s] += move.linesCleared;
+
+      if (move.linesCleared > 0) {
+        int attack = options.attack[move.linesCleared];
+        int cancelled = std::min(attack, pending[s]);
+        pending[s] -= cancelled;
+        sent[s] = attack - cancelled;
+      } else {
+        lost[s] = !receiveGarbage(boards[s], pending[s], holes[s]);
+        pending[s] = 0;
+      }
+    }
+
+    if (lost[0] || lost[1]) {
+      result.winner = lost[0] && lost[1] ? -1 : lost[0] ? 1 : 0;
+      result.pieces++;
+      break;
+    }
+
+    for (int s = 0; s < 2; s++) {
+      pending[1-s] += sent[s];
+      result.sent[s] += sent[s];
+    }
+  }
+
+  return result;
+}
+
+struct VersusSummary {
+  long wins[2] = {};
+  long draws = 0;
+  RunningStats pieces;
+  RunningStats sent[2];
+
+  void add(const VersusResult &result);
+  void merge(const VersusSummary &other);
+};
+
+// Plays matches matches on seeds seed, seed+1, ..., spread over the given
+// threads, with fresh players from makeA() and makeB() for every match.
+// Both are called from several threads at once.
+template <typename Randomizer, typename MakeA, typename MakeB>
+VersusSummary runMatches(MakeA makeA, MakeB makeB, int seed, int matches, const VersusOptions &options,
+                         int threads) {
+  std::vector<VersusSummary> summaries(defaultThreads(threads));
+  parallelFor(matches, threads, [&](int i, int thread) {
+    auto a = makeA();
+    auto b = makeB();
+    summaries[thread].add(playMatch<Randomizer>(a, b, seed + i, options));
+  });
+
+  for (size_t t = 1; t < summaries.size(); t++) summaries[0].merge(summaries[t]);
+  return summaries[0];
+}
+
+#endif
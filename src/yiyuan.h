@@ -2,7 +2,33 @@
 #define _YIYUAN_H_
 
 #include "tetris.h"
+#include "evaluator.h"
 
-DropMove yiyuan(const Board &board, PieceType piece);
+constexpr auto yiyuanEvaluator = makeEvaluator(
+  weighted<AggregateHeight>(-0.510066),
+  weighted<LinesCleared>(0.760666),
+  weighted<Holes>(-0.35663),
+  weighted<Bumpiness>(-0.184483));
+
+template <typename B>
+DropMove yiyuan(const B &board, PieceType piece, MoveSet moves = MoveSet::HardDrops);
+
+// Plays whichever of piece and held scores higher.
+template <typename B>
+DropMove yiyuanHold(const B &board, PieceType piece, PieceType held, MoveSet moves = MoveSet::HardDrops);
+
+struct Yiyuan {
+  MoveSet moves = MoveSet::HardDrops;
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece) const {
+    return yiyuan(board, piece, moves);
+  }
+
+  template <typename B>
+  DropMove operator()(const B &board, PieceType piece, PieceType held) const {
+    return yiyuanHold(board, piece, held, moves);
+  }
+};
 
 #endif